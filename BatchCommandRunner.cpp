@@ -0,0 +1,262 @@
+//
+// Runs a file of commands against a region hierarchy, without any menus or prompts.
+//
+
+#include "BatchCommandRunner.h"
+#include "Instrumentation.h"
+#include "RegionJournal.h"
+#include "Utils.h"
+
+namespace
+{
+    // Return the next space-separated word of the text, and remove it from the text
+    std::string_view nextWord(std::string_view& text)
+    {
+        std::size_t spacePos = text.find(' ');
+        std::string_view word = text.substr(0, spacePos);
+        text = trimView(spacePos == std::string_view::npos ? std::string_view() : text.substr(spacePos + 1));
+        return word;
+    }
+}
+
+// If a journal is provided, every change is recorded in it, just like changes made through the menus
+BatchCommandRunner::BatchCommandRunner(Region& root, std::ostream& out, RegionJournal* journal) :
+        m_root(root), m_out(out), m_journal(journal)
+{
+}
+
+// Runs every command in the input
+//
+// Return the number of commands that failed.
+std::size_t BatchCommandRunner::run(std::istream& commands)
+{
+    std::size_t failureCount = m_failureCount;
+    std::string line;
+    while (std::getline(commands, line))
+        runCommand(line);
+    return m_failureCount - failureCount;
+}
+
+// Runs one command, and if it fails, writes the command and the reason to the output
+//
+// Return true if the command worked or the line wasn't a command.
+bool BatchCommandRunner::runCommand(std::string_view line)
+{
+    line = trimView(line);
+    if (line.empty() || line[0] == '#')
+        return true;
+
+    std::string_view arguments = line;
+    std::string_view command = nextWord(arguments);
+    std::string error;
+    bool succeeded = false;
+    if (command == "create")
+        succeeded = create(arguments, error);
+    else if (command == "edit")
+        succeeded = edit(arguments, error);
+    else if (command == "delete")
+        succeeded = remove(arguments, error);
+    else if (command == "move")
+        succeeded = move(arguments, error);
+    else if (command == "print")
+        succeeded = print(arguments, error);
+    else if (command == "list")
+        succeeded = list(arguments, error);
+    else if (command == "stats")
+        succeeded = stats(arguments, error);
+    else
+        error = "Unknown command";
+
+    m_commandCount++;
+    if (!succeeded)
+    {
+        m_failureCount++;
+        m_out << line << " -- " << error << '\n';
+    }
+    return succeeded;
+}
+
+bool BatchCommandRunner::create(std::string_view arguments, std::string& error)
+{
+    Region* parent = findRegion(arguments, error);
+    if (parent == nullptr)
+        return false;
+
+    RegionPtr region(Region::create(arguments));
+    if (region == nullptr)
+    {
+        error = "Invalid data - no region created";
+        return false;
+    }
+    // A region that can't be added is disposed of, so the message is made first
+    Region& added = *region;
+    std::string notAdded = "A " + parent->getRegionLabel() + " can't contain a " + added.getRegionLabel();
+    if (!parent->addSubregion(std::move(region)))
+    {
+        error = notAdded;
+        return false;
+    }
+    return m_journal == nullptr || checkJournal(m_journal->recordAdd(added), error);
+}
+
+// Nothing is changed unless all of the new values are valid
+bool BatchCommandRunner::edit(std::string_view arguments, std::string& error)
+{
+    Region* region = findRegion(arguments, error);
+    if (region == nullptr)
+        return false;
+
+    std::string_view fields[3];
+    for (int i=0; i<2; i++)
+    {
+        std::size_t commaPos = arguments.find(',');
+        if (commaPos == std::string_view::npos)
+        {
+            error = "Expected <name>,<population>,<area>";
+            return false;
+        }
+        fields[i] = trimView(arguments.substr(0, commaPos));
+        arguments.remove_prefix(commaPos + 1);
+    }
+    fields[2] = trimView(arguments);
+
+    bool isPopulationValid = true;
+    bool isAreaValid = true;
+    unsigned int population = fields[1].empty() ? 0 : parseUnsignedInt(fields[1], &isPopulationValid);
+    double area = fields[2].empty() ? 0 : parseDouble(fields[2], &isAreaValid);
+    if (!isPopulationValid || !isAreaValid)
+    {
+        error = !isPopulationValid ? "Invalid population - nothing updated" : "Invalid area - nothing updated";
+        return false;
+    }
+
+    bool recorded = true;
+    if (!fields[0].empty())
+    {
+        region->setName(std::string(fields[0]));
+        recorded = (m_journal == nullptr || m_journal->recordName(*region)) && recorded;
+    }
+    if (!fields[1].empty())
+    {
+        region->setPopulation(population);
+        recorded = (m_journal == nullptr || m_journal->recordPopulation(*region)) && recorded;
+    }
+    if (!fields[2].empty())
+    {
+        region->setArea(area);
+        recorded = (m_journal == nullptr || m_journal->recordArea(*region)) && recorded;
+    }
+    return checkJournal(recorded, error);
+}
+
+bool BatchCommandRunner::remove(std::string_view arguments, std::string& error)
+{
+    Region* region = findRegion(arguments, error);
+    if (region == nullptr)
+        return false;
+    if (!arguments.empty())
+    {
+        error = "Unexpected text after the id";
+        return false;
+    }
+    if (region == &m_root)
+    {
+        error = "Can't delete the region the commands are run against";
+        return false;
+    }
+
+    Region* parent = region->getParent();
+    unsigned int id = region->getId();
+    parent->removeSubregion(id);
+    return m_journal == nullptr || checkJournal(m_journal->recordRemove(*parent, id), error);
+}
+
+bool BatchCommandRunner::move(std::string_view arguments, std::string& error)
+{
+    Region* region = findRegion(arguments, error);
+    if (region == nullptr)
+        return false;
+    Region* newParent = findRegion(arguments, error);
+    if (newParent == nullptr)
+        return false;
+    if (!arguments.empty())
+    {
+        error = "Unexpected text after the ids";
+        return false;
+    }
+    if (region == &m_root)
+    {
+        error = "Can't move the region the commands are run against";
+        return false;
+    }
+    Region::MoveFailure failure;
+    if (!region->moveTo(*newParent, &failure))
+    {
+        error = region->describeMoveFailure(failure, *newParent);
+        return false;
+    }
+    return m_journal == nullptr || checkJournal(m_journal->recordMove(*region), error);
+}
+
+bool BatchCommandRunner::print(std::string_view arguments, std::string& error)
+{
+    Region* region = findRegion(arguments, error);
+    if (region != nullptr && !arguments.empty())
+    {
+        error = "Unexpected text after the id";
+        region = nullptr;
+    }
+    if (region != nullptr)
+        region->display(m_out, 0, true);
+    return region != nullptr;
+}
+
+bool BatchCommandRunner::list(std::string_view arguments, std::string& error)
+{
+    Region* region = findRegion(arguments, error);
+    if (region != nullptr && !arguments.empty())
+    {
+        error = "Unexpected text after the id";
+        region = nullptr;
+    }
+    if (region != nullptr)
+        region->list(m_out);
+    return region != nullptr;
+}
+
+bool BatchCommandRunner::stats(std::string_view arguments, std::string& error)
+{
+    if (!arguments.empty())
+    {
+        error = "The stats command doesn't take any arguments";
+        return false;
+    }
+    Instrumentation::write(m_out);
+    return true;
+}
+
+// Takes an id off the front of the arguments and looks up the region with that id
+//
+// Return the region, or nullptr with the reason in error if the id isn't valid or isn't in the hierarchy.
+Region* BatchCommandRunner::findRegion(std::string_view& arguments, std::string& error)
+{
+    bool isValid;
+    unsigned int id = parseUnsignedInt(nextWord(arguments), &isValid);
+    Region* region = nullptr;
+    if (!isValid)
+        error = "Invalid id";
+    else
+    {
+        region = (id == m_root.getId()) ? &m_root : m_root.findDescendantById(id);
+        if (region == nullptr)
+            error = "No region with that id";
+    }
+    return region;
+}
+
+bool BatchCommandRunner::checkJournal(bool recorded, std::string& error)
+{
+    if (!recorded)
+        error = "Problem recording the change in the journal -- " + m_journal->getError();
+    return recorded;
+}
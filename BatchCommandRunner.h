@@ -0,0 +1,59 @@
+//
+// Runs a file of commands against a region hierarchy, without any menus or prompts.
+//
+
+#ifndef GEO_REGIONS_BATCH_COMMAND_RUNNER_H
+#define GEO_REGIONS_BATCH_COMMAND_RUNNER_H
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+#include "Region.h"
+
+class RegionJournal;
+
+// Does what the menus do, one command per line, with regions given by id instead of by moving from context to context:
+//
+//  create <parent id> <type>,<name>,<population>,<area>    same format as a line of a data file
+//  edit <id> <name>,<population>,<area>                    leave a field empty to keep its current value
+//  delete <id>
+//  move <id> <new parent id>                               moves the region and all of its sub-regions
+//  print <id>                                              same as the P menu command, in the context of the region
+//  list <id>                                               same as the L menu command, in the context of the region
+//  stats                                                   same as the I menu command
+//
+// Blank lines and lines starting with # are skipped.  Commands can only reach the regions of the hierarchy they are
+// run against.  A command that fails doesn't stop the rest; a line saying why is written to the output instead.
+// Nothing is flushed along the way, so the output goes out in large chunks.
+class BatchCommandRunner {
+private:
+    Region&         m_root;
+    std::ostream&   m_out;
+    RegionJournal*  m_journal;
+    std::size_t     m_commandCount = 0;
+    std::size_t     m_failureCount = 0;
+
+public:
+    BatchCommandRunner(Region& root, std::ostream& out, RegionJournal* journal = nullptr);
+
+    std::size_t run(std::istream& commands);
+    bool runCommand(std::string_view line);
+
+    std::size_t getCommandCount() const { return m_commandCount; }
+    std::size_t getFailureCount() const { return m_failureCount; }
+
+private:
+    bool create(std::string_view arguments, std::string& error);
+    bool edit(std::string_view arguments, std::string& error);
+    bool remove(std::string_view arguments, std::string& error);
+    bool move(std::string_view arguments, std::string& error);
+    bool print(std::string_view arguments, std::string& error);
+    bool list(std::string_view arguments, std::string& error);
+    bool stats(std::string_view arguments, std::string& error);
+    Region* findRegion(std::string_view& arguments, std::string& error);
+    bool checkJournal(bool recorded, std::string& error);
+};
+
+#endif //GEO_REGIONS_BATCH_COMMAND_RUNNER_H
@@ -0,0 +1,17 @@
+//
+// Counts heap allocations, so the benchmarks can report allocations per operation.
+//
+
+#ifndef GEO_REGIONS_ALLOCATION_COUNTER_H
+#define GEO_REGIONS_ALLOCATION_COUNTER_H
+
+#include <cstddef>
+
+// The benchmark program replaces the global operator new with one that counts every call, across all threads, and
+// then allocates with malloc.  Only the Benchmark target is built with the replacement.
+class AllocationCounter {
+public:
+    static std::size_t getCount();
+};
+
+#endif //GEO_REGIONS_ALLOCATION_COUNTER_H
@@ -0,0 +1,117 @@
+//
+// Timing samples and the table of results the benchmarks print.
+//
+
+#include "BenchmarkReport.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// A negative number of allocations means they weren't counted
+void BenchmarkReport::add(const std::string& name, const std::string& unit, double unitsPerRun,
+                          std::vector<double> runSeconds, double allocationsPerUnit)
+{
+    std::sort(runSeconds.begin(), runSeconds.end());
+    m_results.push_back({ name, unit, unitsPerRun, std::move(runSeconds), allocationsPerUnit });
+}
+
+void BenchmarkReport::write(std::ostream& out) const
+{
+    char line[192];
+    std::snprintf(line, sizeof(line), "%-36s %6s %22s %10s %10s %10s %10s %12s\n", "Benchmark", "Runs",
+                  "Throughput", "p50", "p90", "p99", "Max", "Allocs/unit");
+    out << line;
+    for (const Result& result : m_results)
+    {
+        double totalSeconds = std::accumulate(result.runSeconds.begin(), result.runSeconds.end(), 0.0);
+        double rate = (totalSeconds > 0) ? result.unitsPerRun * (double) result.runSeconds.size() / totalSeconds : 0;
+        std::string throughput = formatRate(rate) + " " + result.unit + "/s";
+        char allocations[32] = "-";
+        if (result.allocationsPerUnit >= 0)
+            std::snprintf(allocations, sizeof(allocations), "%.2f", result.allocationsPerUnit);
+        std::snprintf(line, sizeof(line), "%-36s %6zu %22s %10s %10s %10s %10s %12s\n", result.name.c_str(),
+                      result.runSeconds.size(), throughput.c_str(),
+                      formatSeconds(getPercentile(result.runSeconds, 50)).c_str(),
+                      formatSeconds(getPercentile(result.runSeconds, 90)).c_str(),
+                      formatSeconds(getPercentile(result.runSeconds, 99)).c_str(),
+                      formatSeconds(result.runSeconds.empty() ? 0 : result.runSeconds.back()).c_str(), allocations);
+        out << line;
+    }
+    out << "Peak memory: " << (getPeakMemory() + (1 << 19)) / (1 << 20) << " MB" << std::endl;
+}
+
+double BenchmarkReport::getSeconds(Clock::time_point start, Clock::time_point end)
+{
+    return std::chrono::duration<double>(end - start).count();
+}
+
+// Return the most physical memory the process has used so far, in bytes, or 0 if it isn't available
+std::size_t BenchmarkReport::getPeakMemory()
+{
+    std::size_t peak = 0;
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        peak = counters.PeakWorkingSetSize;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+#ifdef __APPLE__
+        peak = (std::size_t) usage.ru_maxrss;
+#else
+        peak = (std::size_t) usage.ru_maxrss * 1024;
+#endif
+    }
+#endif
+    return peak;
+}
+
+// Nearest-rank percentile, so with only a few runs the higher percentiles are the worst run
+double BenchmarkReport::getPercentile(const std::vector<double>& sortedSeconds, double percentile)
+{
+    double result = 0;
+    if (!sortedSeconds.empty())
+    {
+        std::size_t rank = (std::size_t) std::ceil(percentile / 100 * (double) sortedSeconds.size());
+        result = sortedSeconds[std::max<std::size_t>(rank, 1) - 1];
+    }
+    return result;
+}
+
+std::string BenchmarkReport::formatSeconds(double seconds)
+{
+    char text[32];
+    if (seconds < 1e-6)
+        std::snprintf(text, sizeof(text), "%.1f ns", seconds * 1e9);
+    else if (seconds < 1e-3)
+        std::snprintf(text, sizeof(text), "%.1f us", seconds * 1e6);
+    else if (seconds < 1)
+        std::snprintf(text, sizeof(text), "%.1f ms", seconds * 1e3);
+    else
+        std::snprintf(text, sizeof(text), "%.2f s", seconds);
+    return text;
+}
+
+std::string BenchmarkReport::formatRate(double rate)
+{
+    char text[32];
+    if (rate >= 1e9)
+        std::snprintf(text, sizeof(text), "%.2fG", rate / 1e9);
+    else if (rate >= 1e6)
+        std::snprintf(text, sizeof(text), "%.2fM", rate / 1e6);
+    else if (rate >= 1e3)
+        std::snprintf(text, sizeof(text), "%.2fK", rate / 1e3);
+    else
+        std::snprintf(text, sizeof(text), "%.2f", rate);
+    return text;
+}
@@ -0,0 +1,56 @@
+//
+// Timing samples and the table of results the benchmarks print.
+//
+
+#ifndef GEO_REGIONS_BENCHMARK_REPORT_H
+#define GEO_REGIONS_BENCHMARK_REPORT_H
+
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+// Collects how long each run of each benchmark took and writes one line per benchmark: how many units of work were
+// done per second over all of the runs, and the 50th, 90th and 99th percentile and worst time of a single run.  A run
+// can be one unit, e.g., a single lookup, or many, e.g., loading a whole hierarchy.  Benchmarks that count their heap
+// allocations also get the average number per unit.
+class BenchmarkReport {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+private:
+    struct Result {
+        std::string         name;
+        std::string         unit;
+        double              unitsPerRun;
+        std::vector<double> runSeconds;
+        double              allocationsPerUnit;
+    };
+
+    std::vector<Result>     m_results;
+
+public:
+    void add(const std::string& name, const std::string& unit, double unitsPerRun, std::vector<double> runSeconds,
+             double allocationsPerUnit = -1);
+    void write(std::ostream& out) const;
+
+    static double getSeconds(Clock::time_point start, Clock::time_point end);
+    static std::size_t getPeakMemory();
+
+private:
+    static double getPercentile(const std::vector<double>& sortedSeconds, double percentile);
+    static std::string formatSeconds(double seconds);
+    static std::string formatRate(double rate);
+};
+
+// Stream buffer that throws away everything written to it, so the benchmarks measure formatting output, not storing
+// or writing it
+class DiscardBuffer : public std::streambuf {
+protected:
+    int_type overflow(int_type ch) override { return traits_type::not_eof(ch); }
+    std::streamsize xsputn(const char*, std::streamsize count) override { return count; }
+};
+
+#endif //GEO_REGIONS_BENCHMARK_REPORT_H
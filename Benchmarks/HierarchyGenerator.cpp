@@ -0,0 +1,82 @@
+//
+// Writes synthetic data files of any size for the benchmarks.
+//
+
+#include "HierarchyGenerator.h"
+#include "../BufferedWriter.h"
+#include "../Region.h"
+
+HierarchyGenerator::HierarchyGenerator(const FanOut& fanOut, std::uint64_t seed) :
+        m_fanOut(fanOut), m_seed(seed != 0 ? seed : 1)
+{
+}
+
+// Return the number of regions in the hierarchy, including the world
+std::uint64_t HierarchyGenerator::getRegionCount() const
+{
+    std::uint64_t nations = m_fanOut.nations;
+    std::uint64_t states = nations * m_fanOut.states;
+    std::uint64_t counties = states * m_fanOut.counties;
+    std::uint64_t cities = counties * m_fanOut.cities;
+    return 1 + nations + states + counties + cities;
+}
+
+// Return true if the whole file was written, otherwise false with the reason in error
+bool HierarchyGenerator::write(const std::string& filename, std::string* error)
+{
+    BufferedWriter writer(filename);
+    writer.write("1,World,0,5.101e+08\n");
+    for (unsigned int nation=0; nation<m_fanOut.nations; nation++)
+    {
+        std::string nationName = "Nation " + std::to_string(nation);
+        writeRegion(writer, Region::NationType, nationName, m_fanOut.states==0);
+        for (unsigned int state=0; state<m_fanOut.states; state++)
+        {
+            std::string stateName = nationName + " State " + std::to_string(state);
+            writeRegion(writer, Region::StateType, stateName, m_fanOut.counties==0);
+            for (unsigned int county=0; county<m_fanOut.counties; county++)
+            {
+                std::string countyName = stateName + " County " + std::to_string(county);
+                writeRegion(writer, Region::CountyType, countyName, m_fanOut.cities==0);
+                for (unsigned int city=0; city<m_fanOut.cities; city++)
+                    writeRegion(writer, Region::CityType, countyName + " City " + std::to_string(city), true);
+                if (m_fanOut.cities>0)
+                    writer.write("^^^\n");
+            }
+            if (m_fanOut.counties>0)
+                writer.write("^^^\n");
+        }
+        if (m_fanOut.states>0)
+            writer.write("^^^\n");
+    }
+    writer.write("^^^\n");
+
+    bool written = writer.close();
+    if (!written && error != nullptr)
+        *error = writer.getError();
+    return written;
+}
+
+// Writes a region's line, and the end of its (empty) list of sub-regions if it won't have any
+void HierarchyGenerator::writeRegion(BufferedWriter& writer, int regionType, const std::string& name, bool isLeaf)
+{
+    writer.writeUnsigned((unsigned long long) regionType);
+    writer.write(',');
+    writer.write(name);
+    writer.write(',');
+    writer.writeUnsigned(1 + nextRandom() % 1000000);
+    writer.write(',');
+    writer.writeDouble((double) (1 + nextRandom() % 100000) / 10);
+    writer.write('\n');
+    if (isLeaf)
+        writer.write("^^^\n");
+}
+
+// xorshift64, which is plenty random for made-up populations, and never gets stuck since the seed is never 0
+std::uint64_t HierarchyGenerator::nextRandom()
+{
+    m_seed ^= m_seed << 13;
+    m_seed ^= m_seed >> 7;
+    m_seed ^= m_seed << 17;
+    return m_seed;
+}
@@ -0,0 +1,42 @@
+//
+// Writes synthetic data files of any size for the benchmarks.
+//
+
+#ifndef GEO_REGIONS_HIERARCHY_GENERATOR_H
+#define GEO_REGIONS_HIERARCHY_GENERATOR_H
+
+#include <cstdint>
+#include <string>
+
+class BufferedWriter;
+
+// Generates a world with a fixed fan-out at each level: so many nations, so many states in each nation, so many
+// counties in each state, and so many cities in each county.  The file is written one line at a time, so it can be
+// much bigger than memory.  Populations and areas are pseudo-random, but the same seed always gives the same file.
+class HierarchyGenerator {
+public:
+    static const std::uint64_t MAX_REGION_COUNT = 100000000;
+
+    struct FanOut {
+        unsigned int nations = 10;
+        unsigned int states = 20;
+        unsigned int counties = 20;
+        unsigned int cities = 20;
+    };
+
+private:
+    FanOut          m_fanOut;
+    std::uint64_t   m_seed;
+
+public:
+    explicit HierarchyGenerator(const FanOut& fanOut, std::uint64_t seed = 1);
+
+    std::uint64_t getRegionCount() const;
+    bool write(const std::string& filename, std::string* error = nullptr);
+
+private:
+    void writeRegion(BufferedWriter& writer, int regionType, const std::string& name, bool isLeaf);
+    std::uint64_t nextRandom();
+};
+
+#endif //GEO_REGIONS_HIERARCHY_GENERATOR_H
@@ -0,0 +1,163 @@
+//
+// Benchmarks of the hot paths of Region on a generated hierarchy.
+//
+
+#include "RegionBenchmark.h"
+#include "BenchmarkReport.h"
+#include "../Region.h"
+
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    // Results are added up into here, so the compiler can't throw away the work being timed
+    volatile std::uint64_t sink;
+}
+
+RegionBenchmark::RegionBenchmark(const std::string& dataFile, unsigned int runCount, std::uint64_t regionCount) :
+        m_dataFile(dataFile), m_runCount(runCount), m_regionCount(regionCount)
+{
+}
+
+RegionBenchmark::~RegionBenchmark()
+{
+    delete m_world;
+}
+
+// Loads the whole data file through Region::create(std::istream&) on each run, and keeps the last hierarchy loaded
+bool RegionBenchmark::benchmarkCreateFromStream(BenchmarkReport& report)
+{
+    std::vector<double> runSeconds;
+    for (unsigned int run=0; run<m_runCount; run++)
+    {
+        delete m_world;
+        std::ifstream inputStream(m_dataFile);
+        BenchmarkReport::Clock::time_point start = BenchmarkReport::Clock::now();
+        m_world = Region::create(inputStream);
+        runSeconds.push_back(BenchmarkReport::getSeconds(start, BenchmarkReport::Clock::now()));
+        if (m_world==nullptr)
+        {
+            std::cerr << "Could not load " << m_dataFile << std::endl;
+            return false;
+        }
+    }
+    report.add("Region::create(istream)", "regions", (double) m_regionCount, std::move(runSeconds));
+    return true;
+}
+
+bool RegionBenchmark::benchmarkSave(BenchmarkReport& report)
+{
+    if (m_world==nullptr)
+        return false;
+
+    DiscardBuffer discardBuffer;
+    std::ostream discardStream(&discardBuffer);
+    std::vector<double> runSeconds;
+    for (unsigned int run=0; run<m_runCount; run++)
+    {
+        BenchmarkReport::Clock::time_point start = BenchmarkReport::Clock::now();
+        m_world->save(discardStream);
+        runSeconds.push_back(BenchmarkReport::getSeconds(start, BenchmarkReport::Clock::now()));
+    }
+    report.add("Region::save(ostream)", "regions", (double) m_regionCount, std::move(runSeconds));
+    return true;
+}
+
+// Looks up sub-regions at random positions under random regions.  Single lookups are too quick to time one at a time,
+// so each run is LOOKUPS_PER_RUN of them and the percentiles are of the average lookup within a run.  A world with no
+// nations has nothing to look up, so there's nothing to report.
+bool RegionBenchmark::benchmarkGetSubRegionByIndex(BenchmarkReport& report, unsigned int lookupCount)
+{
+    if (m_world==nullptr)
+        return false;
+
+    std::vector<Region*> parents;
+    for (Region* region : getRegions())
+    {
+        if (region->getSubRegionCount()>0)
+            parents.push_back(region);
+    }
+    if (parents.empty())
+        return true;
+
+    // Choose what to look up ahead of time, so choosing isn't part of what is timed
+    std::mt19937_64 random(1);
+    std::vector<std::pair<Region*, int>> lookups(LOOKUPS_PER_RUN);
+    std::vector<double> runSeconds;
+    for (unsigned int run=0; run<(lookupCount + LOOKUPS_PER_RUN - 1) / LOOKUPS_PER_RUN; run++)
+    {
+        for (std::pair<Region*, int>& lookup : lookups)
+        {
+            lookup.first = parents[random() % parents.size()];
+            lookup.second = (int) (random() % (std::uint64_t) lookup.first->getSubRegionCount());
+        }
+
+        std::uint64_t total = 0;
+        BenchmarkReport::Clock::time_point start = BenchmarkReport::Clock::now();
+        for (const std::pair<Region*, int>& lookup : lookups)
+            total += lookup.first->getSubRegionByIndex(lookup.second)->getId();
+        runSeconds.push_back(BenchmarkReport::getSeconds(start, BenchmarkReport::Clock::now()) / LOOKUPS_PER_RUN);
+        sink = sink + total;
+    }
+    report.add("Region::getSubRegionByIndex", "lookups", 1, std::move(runSeconds));
+    return true;
+}
+
+// Asks every region for its total population on each run
+bool RegionBenchmark::benchmarkComputeTotalPopulation(BenchmarkReport& report)
+{
+    if (m_world==nullptr)
+        return false;
+
+    std::vector<Region*> regions = getRegions();
+    std::vector<double> runSeconds;
+    for (unsigned int run=0; run<m_runCount; run++)
+    {
+        std::uint64_t total = 0;
+        BenchmarkReport::Clock::time_point start = BenchmarkReport::Clock::now();
+        for (Region* region : regions)
+            total += region->computeTotalPopulation();
+        runSeconds.push_back(BenchmarkReport::getSeconds(start, BenchmarkReport::Clock::now()));
+        sink = sink + total;
+    }
+    report.add("Region::computeTotalPopulation", "regions", (double) m_regionCount, std::move(runSeconds));
+    return true;
+}
+
+bool RegionBenchmark::benchmarkDisplay(BenchmarkReport& report)
+{
+    if (m_world==nullptr)
+        return false;
+
+    DiscardBuffer discardBuffer;
+    std::ostream discardStream(&discardBuffer);
+    std::vector<double> runSeconds;
+    for (unsigned int run=0; run<m_runCount; run++)
+    {
+        BenchmarkReport::Clock::time_point start = BenchmarkReport::Clock::now();
+        m_world->display(discardStream, 0, true);
+        runSeconds.push_back(BenchmarkReport::getSeconds(start, BenchmarkReport::Clock::now()));
+    }
+    report.add("Region::display", "regions", (double) m_regionCount, std::move(runSeconds));
+    return true;
+}
+
+// Return every region in the hierarchy, parents before their sub-regions
+std::vector<Region*> RegionBenchmark::getRegions() const
+{
+    std::vector<Region*> regions;
+    std::vector<Region*> pending(1, m_world);
+    while (!pending.empty())
+    {
+        Region* region = pending.back();
+        pending.pop_back();
+        regions.push_back(region);
+        for (int i=region->getSubRegionCount()-1; i>=0; i--)
+            pending.push_back(region->getSubRegionByIndex(i));
+    }
+    return regions;
+}
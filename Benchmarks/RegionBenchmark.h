@@ -0,0 +1,43 @@
+//
+// Benchmarks of the hot paths of Region on a generated hierarchy.
+//
+
+#ifndef GEO_REGIONS_REGION_BENCHMARK_H
+#define GEO_REGIONS_REGION_BENCHMARK_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class BenchmarkReport;
+class Region;
+
+// Each benchmark runs the same work several times and adds the time of every run to the report.  The hierarchy is
+// loaded from the data file by the first benchmark and kept for the rest.
+class RegionBenchmark {
+public:
+    static const unsigned int LOOKUPS_PER_RUN = 1000;
+
+private:
+    std::string     m_dataFile;
+    unsigned int    m_runCount;
+    std::uint64_t   m_regionCount;
+    Region*         m_world = nullptr;
+
+public:
+    RegionBenchmark(const std::string& dataFile, unsigned int runCount, std::uint64_t regionCount);
+    ~RegionBenchmark();
+    RegionBenchmark(const RegionBenchmark&) = delete;
+    RegionBenchmark& operator=(const RegionBenchmark&) = delete;
+
+    bool benchmarkCreateFromStream(BenchmarkReport& report);
+    bool benchmarkSave(BenchmarkReport& report);
+    bool benchmarkGetSubRegionByIndex(BenchmarkReport& report, unsigned int lookupCount);
+    bool benchmarkComputeTotalPopulation(BenchmarkReport& report);
+    bool benchmarkDisplay(BenchmarkReport& report);
+
+private:
+    std::vector<Region*> getRegions() const;
+};
+
+#endif //GEO_REGIONS_REGION_BENCHMARK_H
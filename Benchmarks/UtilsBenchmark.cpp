@@ -0,0 +1,154 @@
+//
+// Micro-benchmarks of the parsing functions in Utils, which run several times for every line loaded.
+//
+
+#include "UtilsBenchmark.h"
+#include "AllocationCounter.h"
+#include "BenchmarkReport.h"
+#include "../Utils.h"
+
+#include <cstdint>
+#include <random>
+#include <string_view>
+#include <utility>
+
+namespace
+{
+    // Results are added up into here, so the compiler can't throw away the work being timed
+    volatile std::uint64_t sink;
+
+    const char* const nameWords[] = { "Cache", "Box Elder", "Salt Lake", "North Logan", "United States of America",
+                                      "Davis", "Nevada", "Deutschland", "San Bernardino", "X" };
+    const char* const levelWords[] = { "County", "City", "State", "Nation", "" };
+    const char* const padding[] = { "", "", " ", "  ", "\t", " \t " };
+    const char* const areas[] = { "5.101e+008", "5.101e+08", "1887.761", "234235", "29.82", "2.5E3", "0.5", "11.1",
+                                  "9833520", "1.0e-2" };
+
+    const std::vector<std::string> invalidLines = { "4,Cache County,116909", "", "no commas here", "4,,", ",,,",
+                                                    "4,Cache County" };
+    const std::vector<std::string> invalidInts = { "abc", "4x", "", "99999999999", " - 3", "3.5", "--1", "+" };
+    const std::vector<std::string> invalidUnsignedInts = { "-5", "99999999999", "12a", "1 000", "", "4294967296",
+                                                           "0x10", "+" };
+    const std::vector<std::string> invalidDoubles = { "1.2.3", "abc", "", "1e", "12,5", "e10", "1.0f", "." };
+
+    // Return the inputs repeated or cut down to INPUT_COUNT of them, so every function sees the same number of inputs
+    std::vector<std::string> fill(const std::vector<std::string>& inputs)
+    {
+        std::vector<std::string> filled;
+        for (unsigned int i=0; i<UtilsBenchmark::INPUT_COUNT; i++)
+            filled.push_back(inputs[i % inputs.size()]);
+        return filled;
+    }
+}
+
+// The inputs are generated from a fixed seed, so every run of the benchmarks sees the same ones
+UtilsBenchmark::UtilsBenchmark(unsigned int runCount) :
+        m_runCount(runCount),
+        m_invalidLines(fill(invalidLines)),
+        m_invalidInts(fill(invalidInts)),
+        m_invalidUnsignedInts(fill(invalidUnsignedInts)),
+        m_invalidDoubles(fill(invalidDoubles))
+{
+    std::mt19937 random(1);
+    auto choose = [&random](const auto& choices) { return choices[random() % (sizeof(choices) / sizeof(choices[0]))]; };
+    for (unsigned int i=0; i<INPUT_COUNT; i++)
+    {
+        std::string name = std::string(choose(nameWords)) + " " + choose(levelWords);
+        m_paddedNames.push_back(choose(padding) + name + choose(padding));
+
+        std::string type = std::to_string(1 + random() % 5);
+        m_types.push_back(random() % 4 == 0 ? " " + type + " " : type);
+
+        // Mostly towns and counties, with the odd nation near the top of the range
+        unsigned int population = (random() % 10 == 0) ? (unsigned int) random() : (unsigned int) (random() % 10000000);
+        m_populations.push_back(std::to_string(population));
+
+        std::string area = choose(areas);
+        m_areas.push_back(area);
+
+        m_lines.push_back(type + "," + m_paddedNames.back() + "," + std::to_string(population) + "," + area);
+    }
+}
+
+void UtilsBenchmark::benchmarkSplit(BenchmarkReport& report)
+{
+    run(report, "split", m_lines, [](const std::string& line) {
+        std::string pieces[4];
+        return split(line, ',', pieces, 4) ? pieces[1].size() : 0;
+    });
+    run(report, "split (view)", m_lines, [](const std::string& line) {
+        std::string_view pieces[4];
+        return split(std::string_view(line), ',', pieces, 4) ? pieces[1].size() : 0;
+    });
+    run(report, "split invalid", m_invalidLines, [](const std::string& line) {
+        std::string pieces[4];
+        return split(line, ',', pieces, 4) ? pieces[1].size() : 0;
+    });
+    run(report, "split invalid (view)", m_invalidLines, [](const std::string& line) {
+        std::string_view pieces[4];
+        return split(std::string_view(line), ',', pieces, 4) ? pieces[1].size() : 0;
+    });
+}
+
+void UtilsBenchmark::benchmarkTrim(BenchmarkReport& report)
+{
+    run(report, "trim", m_paddedNames, [](const std::string& name) { return trim(name).size(); });
+    run(report, "trimView", m_paddedNames, [](const std::string& name) { return trimView(name).size(); });
+}
+
+void UtilsBenchmark::benchmarkConvertToInt(BenchmarkReport& report)
+{
+    auto convert = [](const std::string& s) { bool valid; return (std::size_t) convertStringToInt(s, &valid) + valid; };
+    auto parse = [](const std::string& s) { bool valid; return (std::size_t) parseInt(s, &valid) + valid; };
+    run(report, "convertStringToInt", m_types, convert);
+    run(report, "parseInt", m_types, parse);
+    run(report, "convertStringToInt invalid", m_invalidInts, convert);
+    run(report, "parseInt invalid", m_invalidInts, parse);
+}
+
+void UtilsBenchmark::benchmarkConvertToUnsignedInt(BenchmarkReport& report)
+{
+    auto convert = [](const std::string& s) {
+        bool valid;
+        return (std::size_t) convertStringToUnsignedInt(s, &valid) + valid;
+    };
+    auto parse = [](const std::string& s) { bool valid; return (std::size_t) parseUnsignedInt(s, &valid) + valid; };
+    run(report, "convertStringToUnsignedInt", m_populations, convert);
+    run(report, "parseUnsignedInt", m_populations, parse);
+    run(report, "convertStringToUnsignedInt invalid", m_invalidUnsignedInts, convert);
+    run(report, "parseUnsignedInt invalid", m_invalidUnsignedInts, parse);
+}
+
+void UtilsBenchmark::benchmarkConvertToDouble(BenchmarkReport& report)
+{
+    auto convert = [](const std::string& s) { bool valid; return (std::size_t) convertStringToDouble(s, &valid) + valid; };
+    auto parse = [](const std::string& s) { bool valid; return (std::size_t) parseDouble(s, &valid) + valid; };
+    run(report, "convertStringToDouble", m_areas, convert);
+    run(report, "parseDouble", m_areas, parse);
+    run(report, "convertStringToDouble invalid", m_invalidDoubles, convert);
+    run(report, "parseDouble invalid", m_invalidDoubles, parse);
+}
+
+// Calls the operation on the inputs in turn, OPERATIONS_PER_RUN times per run, and adds the times and the allocations
+// per call to the report
+template <typename Operation>
+void UtilsBenchmark::run(BenchmarkReport& report, const std::string& name, const std::vector<std::string>& inputs,
+                         Operation operation)
+{
+    std::vector<double> runSeconds;
+    std::size_t allocationCount = 0;
+    for (unsigned int runNumber=0; runNumber<m_runCount; runNumber++)
+    {
+        std::uint64_t total = 0;
+        std::size_t allocationsBefore = AllocationCounter::getCount();
+        BenchmarkReport::Clock::time_point start = BenchmarkReport::Clock::now();
+        for (unsigned int i=0; i<OPERATIONS_PER_RUN; i++)
+            total += operation(inputs[i % INPUT_COUNT]);
+        BenchmarkReport::Clock::time_point end = BenchmarkReport::Clock::now();
+        allocationCount += AllocationCounter::getCount() - allocationsBefore;
+        runSeconds.push_back(BenchmarkReport::getSeconds(start, end) / OPERATIONS_PER_RUN);
+        sink = sink + total;
+    }
+    report.add(name, "ops", 1, std::move(runSeconds),
+               (double) allocationCount / ((double) m_runCount * OPERATIONS_PER_RUN));
+}
@@ -0,0 +1,49 @@
+//
+// Micro-benchmarks of the parsing functions in Utils, which run several times for every line loaded.
+//
+
+#ifndef GEO_REGIONS_UTILS_BENCHMARK_H
+#define GEO_REGIONS_UTILS_BENCHMARK_H
+
+#include <string>
+#include <vector>
+
+class BenchmarkReport;
+
+// Each function is run against inputs shaped like the fields of a real data file, e.g., padded names, large
+// populations and areas in scientific notation, and separately against invalid inputs that take the rejection paths.
+// The std::string functions and their string_view counterparts are benchmarked side by side.  Each run is
+// OPERATIONS_PER_RUN calls, and the percentiles are of the average call within a run.
+class UtilsBenchmark {
+public:
+    static const unsigned int OPERATIONS_PER_RUN = 10000;
+    static const unsigned int INPUT_COUNT = 1000;
+
+private:
+    unsigned int                m_runCount;
+    std::vector<std::string>    m_lines;
+    std::vector<std::string>    m_paddedNames;
+    std::vector<std::string>    m_types;
+    std::vector<std::string>    m_populations;
+    std::vector<std::string>    m_areas;
+    std::vector<std::string>    m_invalidLines;
+    std::vector<std::string>    m_invalidInts;
+    std::vector<std::string>    m_invalidUnsignedInts;
+    std::vector<std::string>    m_invalidDoubles;
+
+public:
+    explicit UtilsBenchmark(unsigned int runCount);
+
+    void benchmarkSplit(BenchmarkReport& report);
+    void benchmarkTrim(BenchmarkReport& report);
+    void benchmarkConvertToInt(BenchmarkReport& report);
+    void benchmarkConvertToUnsignedInt(BenchmarkReport& report);
+    void benchmarkConvertToDouble(BenchmarkReport& report);
+
+private:
+    template <typename Operation>
+    void run(BenchmarkReport& report, const std::string& name, const std::vector<std::string>& inputs,
+             Operation operation);
+};
+
+#endif //GEO_REGIONS_UTILS_BENCHMARK_H
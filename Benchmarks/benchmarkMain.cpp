@@ -0,0 +1,121 @@
+//
+// Benchmarks of the hot paths, on a generated hierarchy of any size.
+//
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#include "BenchmarkReport.h"
+#include "HierarchyGenerator.h"
+#include "RegionBenchmark.h"
+#include "UtilsBenchmark.h"
+#include "../Utils.h"
+
+namespace
+{
+    // The micro-benchmarks are quick, so they always get plenty of runs
+    const unsigned int UTILS_RUN_COUNT = 200;
+
+    void writeUsage()
+    {
+        std::cerr << "Usage: Benchmark [--nations N] [--states N] [--counties N] [--cities N] [--runs N] [--lookups N]"
+                  << " [--seed N] [--file data file] [--utils-only]" << std::endl
+                  << "  --nations, --states, --counties, --cities set how many sub-regions each region at that level"
+                  << " has (defaults 10, 20, 20, 20)" << std::endl
+                  << "  --runs sets how many times each benchmark runs (default 5)" << std::endl
+                  << "  --lookups sets how many sub-region lookups are timed (default 1000000)" << std::endl
+                  << "  --file sets where the generated data file is written (default benchmark-data.txt)"
+                  << std::endl
+                  << "  --utils-only runs just the micro-benchmarks of the parsing functions" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    HierarchyGenerator::FanOut fanOut;
+    unsigned int runCount = 5;
+    unsigned int lookupCount = 1000000;
+    unsigned int seed = 1;
+    std::string dataFile = "benchmark-data.txt";
+    bool isUtilsOnly = false;
+
+    bool isValid = true;
+    for (int i=1; i<argc && isValid; i++)
+    {
+        std::string option = argv[i];
+        std::string value = (i+1<argc) ? argv[i+1] : "";
+        unsigned int number = 0;
+        if (option=="--utils-only")
+            isUtilsOnly = true;
+        else if (option=="--file")
+        {
+            dataFile = value;
+            isValid = !value.empty();
+            i++;
+        }
+        else
+        {
+            number = parseUnsignedInt(value, &isValid);
+            i++;
+        }
+
+        if (option=="--nations")
+            fanOut.nations = number;
+        else if (option=="--states")
+            fanOut.states = number;
+        else if (option=="--counties")
+            fanOut.counties = number;
+        else if (option=="--cities")
+            fanOut.cities = number;
+        else if (option=="--runs")
+            runCount = number;
+        else if (option=="--lookups")
+            lookupCount = number;
+        else if (option=="--seed")
+            seed = number;
+        else if (option!="--utils-only" && option!="--file")
+            isValid = false;
+    }
+
+    HierarchyGenerator generator(fanOut, seed);
+    std::uint64_t regionCount = generator.getRegionCount();
+    if (!isValid || runCount==0 || regionCount>HierarchyGenerator::MAX_REGION_COUNT)
+    {
+        if (regionCount>HierarchyGenerator::MAX_REGION_COUNT)
+        {
+            std::cerr << regionCount << " regions is more than the limit of " << HierarchyGenerator::MAX_REGION_COUNT
+                      << std::endl;
+        }
+        writeUsage();
+        return 1;
+    }
+
+    BenchmarkReport report;
+    UtilsBenchmark utilsBenchmark(UTILS_RUN_COUNT);
+    utilsBenchmark.benchmarkSplit(report);
+    utilsBenchmark.benchmarkTrim(report);
+    utilsBenchmark.benchmarkConvertToInt(report);
+    utilsBenchmark.benchmarkConvertToUnsignedInt(report);
+    utilsBenchmark.benchmarkConvertToDouble(report);
+
+    bool succeeded = true;
+    if (!isUtilsOnly)
+    {
+        std::cout << "Generating " << regionCount << " regions in " << dataFile << std::endl;
+        std::string error;
+        if (!generator.write(dataFile, &error))
+        {
+            std::cerr << "Problem writing " << dataFile << " -- " << error << std::endl;
+            return 1;
+        }
+
+        RegionBenchmark benchmark(dataFile, runCount, regionCount);
+        succeeded = benchmark.benchmarkCreateFromStream(report) && benchmark.benchmarkSave(report) &&
+                    benchmark.benchmarkGetSubRegionByIndex(report, lookupCount) &&
+                    benchmark.benchmarkComputeTotalPopulation(report) && benchmark.benchmarkDisplay(report);
+        std::remove(dataFile.c_str());
+    }
+    report.write(std::cout);
+    return succeeded ? 0 : 1;
+}
@@ -0,0 +1,186 @@
+//
+// Output buffer that hands text to a file or stream in large chunks.
+//
+
+#include "BufferedWriter.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // The buffer of the last writer to finish on this thread, kept for the next writer that wants one of the same
+    // size, so that a short save doesn't allocate and clear a whole new buffer every time
+    thread_local std::vector<char> spareBuffer;
+}
+
+BufferedWriter::BufferedWriter(std::ostream& out, std::size_t bufferSize) : m_stream(&out)
+{
+    takeBuffer(bufferSize);
+}
+
+// Opens the file for writing, replacing it if it exists.  Check isOpen() to see whether that worked.
+BufferedWriter::BufferedWriter(const std::string& filename, std::size_t bufferSize)
+{
+    takeBuffer(bufferSize);
+#ifdef _WIN32
+    m_fileStream.open(filename, std::ios::binary | std::ios::trunc);
+    if (m_fileStream.is_open())
+        m_stream = &m_fileStream;
+#else
+    m_fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+    if (!isOpen())
+        fail("Could not open " + filename + ": " + std::strerror(errno));
+}
+
+BufferedWriter::~BufferedWriter()
+{
+    close();
+    if (m_buffer.size() >= spareBuffer.size())
+        spareBuffer.swap(m_buffer);
+}
+
+// Uses the spare buffer if it is the right size, otherwise allocates one
+void BufferedWriter::takeBuffer(std::size_t bufferSize)
+{
+    bufferSize = std::max(bufferSize, MIN_BUFFER_SIZE);
+    if (spareBuffer.size() == bufferSize)
+        m_buffer.swap(spareBuffer);
+    else
+        m_buffer.resize(bufferSize);
+}
+
+void BufferedWriter::write(std::string_view text)
+{
+    while (!text.empty() && !m_failed)
+    {
+        if (m_used == m_buffer.size())
+            writeBuffer();
+
+        std::size_t length = std::min(text.length(), m_buffer.size() - m_used);
+        std::memcpy(m_buffer.data() + m_used, text.data(), length);
+        m_used += length;
+        text.remove_prefix(length);
+    }
+}
+
+void BufferedWriter::write(char ch)
+{
+    reserve(1);
+    if (!m_failed)
+        m_buffer[m_used++] = ch;
+}
+
+void BufferedWriter::writeUnsigned(unsigned long long value)
+{
+    reserve(20);
+    if (!m_failed)
+        m_used = std::to_chars(m_buffer.data() + m_used, m_buffer.data() + m_buffer.size(), value).ptr - m_buffer.data();
+}
+
+// Formats the value like std::ostream does by default, i.e., %g with 6 significant digits
+void BufferedWriter::writeDouble(double value)
+{
+    char text[32];
+    int length = std::snprintf(text, sizeof(text), "%g", value);
+    if (length > 0)
+        write(std::string_view(text, (std::size_t) length));
+}
+
+// Passes everything buffered so far on to the file or stream
+//
+// Return true if everything written so far has made it out, otherwise false.
+bool BufferedWriter::flush()
+{
+    if (!m_failed && writeBuffer() && m_stream != nullptr)
+    {
+        m_stream->flush();
+        if (!m_stream->good())
+            fail("Could not flush the output stream");
+    }
+    return !m_failed;
+}
+
+// Flushes what is left and, for a file this writer opened, closes it.  If syncToDisk is true, the file is also
+// synced to disk first, so the data survives a crash once close returns.  Syncing once here, rather than as the
+// buffer fills, keeps the cost to a single sync per file.
+//
+// Return true if everything written has made it out (and, if requested, to disk), otherwise false.
+bool BufferedWriter::close(bool syncToDisk)
+{
+    flush();
+#ifndef _WIN32
+    if (m_fd >= 0)
+    {
+        if (syncToDisk && !m_failed && ::fsync(m_fd) != 0)
+            fail(std::string("Could not sync to disk: ") + std::strerror(errno));
+        if (::close(m_fd) != 0 && !m_failed)
+            fail(std::string("Could not close the file: ") + std::strerror(errno));
+        m_fd = -1;
+    }
+#else
+    if (m_fileStream.is_open())
+    {
+        m_fileStream.close();
+        m_stream = nullptr;
+    }
+#endif
+    return !m_failed;
+}
+
+// Makes sure there is room for length more characters in the buffer, writing it out if necessary
+void BufferedWriter::reserve(std::size_t length)
+{
+    if (m_buffer.size() - m_used < length)
+        writeBuffer();
+}
+
+bool BufferedWriter::writeBuffer()
+{
+    std::size_t written = 0;
+    while (written < m_used && !m_failed)
+    {
+        if (m_stream != nullptr)
+        {
+            m_stream->write(m_buffer.data() + written, m_used - written);
+            if (m_stream->good())
+                written = m_used;
+            else
+                fail("Could not write to the output stream");
+        }
+#ifndef _WIN32
+        else if (m_fd >= 0)
+        {
+            ssize_t result = ::write(m_fd, m_buffer.data() + written, m_used - written);
+            if (result >= 0)
+                written += (std::size_t) result;
+            else if (errno != EINTR)
+                fail(std::string("Could not write to the file: ") + std::strerror(errno));
+        }
+#endif
+        else
+        {
+            fail("Nothing to write to");
+        }
+    }
+    m_used = 0;
+    return !m_failed;
+}
+
+void BufferedWriter::fail(const std::string& error)
+{
+    if (!m_failed)
+    {
+        m_failed = true;
+        m_error = error;
+    }
+}
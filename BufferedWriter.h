@@ -0,0 +1,62 @@
+//
+// Output buffer that hands text to a file or stream in large chunks.
+//
+
+#ifndef GEO_REGIONS_BUFFERED_WRITER_H
+#define GEO_REGIONS_BUFFERED_WRITER_H
+
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Collects output in one large buffer that is reused for the life of the writer, and only passes it on when the
+// buffer fills up or flush() is called, so writing many short lines costs a handful of write calls instead of one
+// per line.  When a writer is done, its buffer is kept for the next writer on the same thread.  Numbers are formatted the same way an std::ostream with default settings would format them.
+//
+// Errors are sticky: once a write fails, later writes are dropped and flush() and close() return false, with the
+// reason available from getError().
+class BufferedWriter {
+public:
+    static const std::size_t DEFAULT_BUFFER_SIZE = 1 << 20;
+    static constexpr std::size_t MIN_BUFFER_SIZE = 64;
+
+private:
+    std::vector<char>   m_buffer;
+    std::size_t         m_used = 0;
+    std::ostream*       m_stream = nullptr;
+    int                 m_fd = -1;
+    bool                m_failed = false;
+    std::string         m_error;
+#ifdef _WIN32
+    std::ofstream       m_fileStream;
+#endif
+
+public:
+    explicit BufferedWriter(std::ostream& out, std::size_t bufferSize = DEFAULT_BUFFER_SIZE);
+    explicit BufferedWriter(const std::string& filename, std::size_t bufferSize = DEFAULT_BUFFER_SIZE);
+    ~BufferedWriter();
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+    bool isOpen() const { return m_stream != nullptr || m_fd >= 0; }
+    bool hasFailed() const { return m_failed; }
+    const std::string& getError() const { return m_error; }
+
+    void write(std::string_view text);
+    void write(char ch);
+    void writeUnsigned(unsigned long long value);
+    void writeDouble(double value);
+
+    bool flush();
+    bool close(bool syncToDisk = false);
+
+private:
+    void takeBuffer(std::size_t bufferSize);
+    void reserve(std::size_t length);
+    bool writeBuffer();
+    void fail(const std::string& error);
+};
+
+#endif //GEO_REGIONS_BUFFERED_WRITER_H
@@ -3,7 +3,12 @@
 //
 
 #include "City.h"
-City::City(const std::string data[]) : Region(CityType, data)
+City::City(const std::string_view data[]) : Region(CityType, data)
+{
+    validate();
+}
+
+City::City(std::string_view name, unsigned int population, double area) : Region(CityType, name, population, area)
 {
     validate();
 }
@@ -7,11 +7,15 @@
 #include "Region.h"
 
 #include <string>
+#include <string_view>
 
 class City : public Region
 {
 public:
-    City(const std::string data[]);
+    static constexpr RegionType regionType = CityType;
+
+    City(const std::string_view data[]);
+    City(std::string_view name, unsigned int population, double area);
 };
 
 #endif //GEO_REGIONS_CITY_H
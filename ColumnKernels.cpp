@@ -0,0 +1,218 @@
+//
+// Vectorized scans over the columns of a region hierarchy.
+//
+
+#include "ColumnKernels.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define GEO_REGIONS_AVX2_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    const std::size_t ROWS_PER_WORD = 64;
+
+    unsigned int lowestBit(std::uint64_t bits)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return (unsigned int) __builtin_ctzll(bits);
+#else
+        unsigned int bit = 0;
+        while ((bits & 1) == 0)
+        {
+            bits >>= 1;
+            bit++;
+        }
+        return bit;
+#endif
+    }
+
+    void computeDensitiesScalar(const std::uint32_t* populations, const double* areas, double* densities,
+                                std::size_t count)
+    {
+        for (std::size_t i=0; i<count; i++)
+            densities[i] = (areas[i] > 0) ? (double) populations[i] / areas[i] : 0;
+    }
+
+    template <typename T>
+    void selectScalar(const T* values, std::size_t count, T min, T max, std::uint64_t* bitmap)
+    {
+        for (std::size_t i=0; i<count; i++)
+        {
+            if (values[i] >= min && values[i] <= max)
+                bitmap[i / ROWS_PER_WORD] |= (std::uint64_t) 1 << (i % ROWS_PER_WORD);
+        }
+    }
+
+    void selectUnsignedScalar(const std::uint32_t* values, std::size_t count, std::uint32_t min, std::uint32_t max,
+                              std::uint64_t* bitmap)
+    {
+        selectScalar(values, count, min, max, bitmap);
+    }
+
+    void selectDoubleScalar(const double* values, std::size_t count, double min, double max, std::uint64_t* bitmap)
+    {
+        selectScalar(values, count, min, max, bitmap);
+    }
+
+#ifdef GEO_REGIONS_AVX2_KERNELS
+    // Four densities at a time.  The populations are unsigned, so they are shifted into the signed range to be
+    // converted and shifted back afterwards, which is exact in a double.
+    __attribute__((target("avx2")))
+    void computeDensitiesAVX2(const std::uint32_t* populations, const double* areas, double* densities,
+                              std::size_t count)
+    {
+        const __m128i signBit = _mm_set1_epi32((int) 0x80000000u);
+        const __m256d signOffset = _mm256_set1_pd(2147483648.0);
+        const __m256d zero = _mm256_setzero_pd();
+
+        std::size_t i = 0;
+        for (; i+4<=count; i+=4)
+        {
+            __m128i population = _mm_xor_si128(_mm_loadu_si128((const __m128i*) (populations + i)), signBit);
+            __m256d populationAsDouble = _mm256_add_pd(_mm256_cvtepi32_pd(population), signOffset);
+            __m256d area = _mm256_loadu_pd(areas + i);
+            __m256d hasArea = _mm256_cmp_pd(area, zero, _CMP_GT_OQ);
+            _mm256_storeu_pd(densities + i, _mm256_and_pd(_mm256_div_pd(populationAsDouble, area), hasArea));
+        }
+        computeDensitiesScalar(populations + i, areas + i, densities + i, count - i);
+    }
+
+    // Eight values at a time, using unsigned min and max to do unsigned comparisons
+    __attribute__((target("avx2")))
+    void selectUnsignedAVX2(const std::uint32_t* values, std::size_t count, std::uint32_t min, std::uint32_t max,
+                            std::uint64_t* bitmap)
+    {
+        const __m256i low = _mm256_set1_epi32((int) min);
+        const __m256i high = _mm256_set1_epi32((int) max);
+
+        std::size_t fullWords = count / ROWS_PER_WORD;
+        for (std::size_t word=0; word<fullWords; word++)
+        {
+            std::uint64_t bits = 0;
+            for (std::size_t j=0; j<ROWS_PER_WORD; j+=8)
+            {
+                __m256i value = _mm256_loadu_si256((const __m256i*) (values + word * ROWS_PER_WORD + j));
+                __m256i atLeastLow = _mm256_cmpeq_epi32(_mm256_max_epu32(value, low), value);
+                __m256i atMostHigh = _mm256_cmpeq_epi32(_mm256_min_epu32(value, high), value);
+                __m256i inRange = _mm256_and_si256(atLeastLow, atMostHigh);
+                bits |= (std::uint64_t) (unsigned) _mm256_movemask_ps(_mm256_castsi256_ps(inRange)) << j;
+            }
+            bitmap[word] = bits;
+        }
+
+        std::size_t done = fullWords * ROWS_PER_WORD;
+        selectScalar(values + done, count - done, min, max, bitmap + fullWords);
+    }
+
+    // Four values at a time, with ordered comparisons so that NaN is never in range
+    __attribute__((target("avx2")))
+    void selectDoubleAVX2(const double* values, std::size_t count, double min, double max, std::uint64_t* bitmap)
+    {
+        const __m256d low = _mm256_set1_pd(min);
+        const __m256d high = _mm256_set1_pd(max);
+
+        std::size_t fullWords = count / ROWS_PER_WORD;
+        for (std::size_t word=0; word<fullWords; word++)
+        {
+            std::uint64_t bits = 0;
+            for (std::size_t j=0; j<ROWS_PER_WORD; j+=4)
+            {
+                __m256d value = _mm256_loadu_pd(values + word * ROWS_PER_WORD + j);
+                __m256d inRange = _mm256_and_pd(_mm256_cmp_pd(value, low, _CMP_GE_OQ),
+                                                _mm256_cmp_pd(value, high, _CMP_LE_OQ));
+                bits |= (std::uint64_t) (unsigned) _mm256_movemask_pd(inRange) << j;
+            }
+            bitmap[word] = bits;
+        }
+
+        std::size_t done = fullWords * ROWS_PER_WORD;
+        selectScalar(values + done, count - done, min, max, bitmap + fullWords);
+    }
+#endif
+}
+
+std::atomic<const ColumnKernels::Kernels*> ColumnKernels::m_kernels(nullptr);
+
+bool ColumnKernels::isSupported(InstructionSet instructionSet)
+{
+    bool supported = (instructionSet == Scalar);
+#ifdef GEO_REGIONS_AVX2_KERNELS
+    if (instructionSet == AVX2)
+        supported = __builtin_cpu_supports("avx2");
+#endif
+    return supported;
+}
+
+ColumnKernels::InstructionSet ColumnKernels::getInstructionSet()
+{
+    return getKernels().instructionSet;
+}
+
+// Switches to the kernels for the instruction set, e.g., to compare them with the others
+//
+// Return false if the processor doesn't support the instruction set, in which case nothing changes.
+bool ColumnKernels::setInstructionSet(InstructionSet instructionSet)
+{
+    const Kernels* kernels = isSupported(instructionSet) ? findKernels(instructionSet) : nullptr;
+    if (kernels != nullptr)
+        m_kernels.store(kernels, std::memory_order_release);
+    return kernels != nullptr;
+}
+
+// Fills in population / area for each row, or 0 for rows without an area
+void ColumnKernels::computeDensities(const std::uint32_t* populations, const double* areas, double* densities,
+                                     std::size_t count)
+{
+    getKernels().computeDensities(populations, areas, densities, count);
+}
+
+RowBitmap ColumnKernels::selectRange(const std::uint32_t* values, std::size_t count, std::uint32_t min,
+                                     std::uint32_t max)
+{
+    RowBitmap bitmap((count + ROWS_PER_WORD - 1) / ROWS_PER_WORD, 0);
+    getKernels().selectUnsigned(values, count, min, max, bitmap.data());
+    return bitmap;
+}
+
+RowBitmap ColumnKernels::selectRange(const double* values, std::size_t count, double min, double max)
+{
+    RowBitmap bitmap((count + ROWS_PER_WORD - 1) / ROWS_PER_WORD, 0);
+    getKernels().selectDouble(values, count, min, max, bitmap.data());
+    return bitmap;
+}
+
+// Return the rows whose bits are set, in order
+std::vector<std::uint32_t> ColumnKernels::getRows(const RowBitmap& bitmap)
+{
+    std::vector<std::uint32_t> rows;
+    for (std::size_t word=0; word<bitmap.size(); word++)
+    {
+        for (std::uint64_t bits = bitmap[word]; bits != 0; bits &= bits - 1)
+            rows.push_back((std::uint32_t) (word * ROWS_PER_WORD + lowestBit(bits)));
+    }
+    return rows;
+}
+
+const ColumnKernels::Kernels& ColumnKernels::getKernels()
+{
+    const Kernels* kernels = m_kernels.load(std::memory_order_acquire);
+    if (kernels == nullptr)
+    {
+        kernels = findKernels(isSupported(AVX2) ? AVX2 : Scalar);
+        m_kernels.store(kernels, std::memory_order_release);
+    }
+    return *kernels;
+}
+
+const ColumnKernels::Kernels* ColumnKernels::findKernels(InstructionSet instructionSet)
+{
+    static const Kernels scalarKernels = { Scalar, computeDensitiesScalar, selectUnsignedScalar, selectDoubleScalar };
+#ifdef GEO_REGIONS_AVX2_KERNELS
+    static const Kernels avx2Kernels = { AVX2, computeDensitiesAVX2, selectUnsignedAVX2, selectDoubleAVX2 };
+    if (instructionSet == AVX2)
+        return &avx2Kernels;
+#endif
+    return (instructionSet == Scalar) ? &scalarKernels : nullptr;
+}
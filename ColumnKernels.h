@@ -0,0 +1,54 @@
+//
+// Vectorized scans over the columns of a region hierarchy.
+//
+
+#ifndef GEO_REGIONS_COLUMN_KERNELS_H
+#define GEO_REGIONS_COLUMN_KERNELS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One bit per row, row i being bit i % 64 of word i / 64.  Bits past the last row are always 0.
+typedef std::vector<std::uint64_t> RowBitmap;
+
+// The inner loops of the column scans, written once with AVX2 intrinsics and once in plain C++.  The AVX2 versions
+// are compiled for AVX2 on their own, so the rest of the program doesn't need to be, and are used only if the
+// processor supports them, which is checked once, the first time a kernel is called.  Both versions give exactly the
+// same results.
+//
+// Ranges are inclusive, and NaN is never in a range.
+class ColumnKernels {
+public:
+    typedef enum InstructionSet { Scalar, AVX2 } x;
+
+private:
+    struct Kernels {
+        InstructionSet instructionSet;
+        void (*computeDensities)(const std::uint32_t* populations, const double* areas, double* densities,
+                                 std::size_t count);
+        void (*selectUnsigned)(const std::uint32_t* values, std::size_t count, std::uint32_t min, std::uint32_t max,
+                               std::uint64_t* bitmap);
+        void (*selectDouble)(const double* values, std::size_t count, double min, double max, std::uint64_t* bitmap);
+    };
+
+    static std::atomic<const Kernels*> m_kernels;
+
+public:
+    static bool isSupported(InstructionSet instructionSet);
+    static InstructionSet getInstructionSet();
+    static bool setInstructionSet(InstructionSet instructionSet);
+
+    static void computeDensities(const std::uint32_t* populations, const double* areas, double* densities,
+                                 std::size_t count);
+    static RowBitmap selectRange(const std::uint32_t* values, std::size_t count, std::uint32_t min, std::uint32_t max);
+    static RowBitmap selectRange(const double* values, std::size_t count, double min, double max);
+    static std::vector<std::uint32_t> getRows(const RowBitmap& bitmap);
+
+private:
+    static const Kernels& getKernels();
+    static const Kernels* findKernels(InstructionSet instructionSet);
+};
+
+#endif //GEO_REGIONS_COLUMN_KERNELS_H
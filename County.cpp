@@ -4,7 +4,12 @@
 
 #include "County.h"
 
-County::County(const std::string data[]) : Region(CountyType, data)
+County::County(const std::string_view data[]) : Region(CountyType, data)
+{
+    validate();
+}
+
+County::County(std::string_view name, unsigned int population, double area) : Region(CountyType, name, population, area)
 {
     validate();
 }
@@ -8,11 +8,15 @@
 #include "Region.h"
 
 #include <string>
+#include <string_view>
 
 class County : public Region
 {
 public:
-    County(const std::string data[]);
+    static constexpr RegionType regionType = CountyType;
+
+    County(const std::string_view data[]);
+    County(std::string_view name, unsigned int population, double area);
 };
 
 #endif //GEO_REGIONS_COUNTY_H
@@ -5,7 +5,7 @@
 #include "CountyUserInterface.h"
 #include "Menu.h"
 
-CountyUserInterface::CountyUserInterface(Region* region) : UserInterface(region)
+CountyUserInterface::CountyUserInterface(Region* region, RegionJournal* journal) : UserInterface(region, journal)
 {
 }
 
@@ -23,5 +23,6 @@ void CountyUserInterface::setupMenu()
     m_menu->addOption("E", "Edit a city");
     m_menu->addOption("P", "Print a report containing all counties or cities in this state");
     m_menu->addOption("D", "Delete a city");
+    m_menu->addOption("R", "Relocate a city to another state or county");
 }
 
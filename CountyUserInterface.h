@@ -10,7 +10,7 @@
 class CountyUserInterface : public UserInterface
 {
 public:
-    CountyUserInterface(Region* region);
+    CountyUserInterface(Region* region, RegionJournal* journal = nullptr);
 
 protected:
     Region::RegionType getSubRegionType();
@@ -0,0 +1,139 @@
+//
+// Counters and timers around the hot paths, cheap enough to leave on in a live deployment.
+//
+
+#include "Instrumentation.h"
+
+#include <iomanip>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    const char* const counterNames[] = { "Regions created", "Parse failures", "Id lookups", "Id lookup misses" };
+    const char* const timerNames[] = { "Load from a data file", "Load from a stream", "Save to a data file",
+                                       "Load from a snapshot", "Save to a snapshot", "Roll up totals" };
+}
+
+// The blocks of the threads that are still running, and the totals of the ones that have exited
+struct Instrumentation::Registry {
+    std::mutex                  mutex;
+    std::vector<ThreadBlock*>   liveBlocks;
+    Totals                      exitedTotals;
+};
+
+thread_local Instrumentation::ThreadBlock Instrumentation::m_threadBlock;
+
+Instrumentation::ThreadBlock::ThreadBlock()
+{
+    Registry& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.liveBlocks.push_back(this);
+}
+
+Instrumentation::ThreadBlock::~ThreadBlock()
+{
+    Registry& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    addTo(registry.exitedTotals);
+    for (std::size_t i=0; i<registry.liveBlocks.size(); i++)
+    {
+        if (registry.liveBlocks[i] == this)
+        {
+            registry.liveBlocks[i] = registry.liveBlocks.back();
+            registry.liveBlocks.pop_back();
+            break;
+        }
+    }
+}
+
+void Instrumentation::ThreadBlock::addTo(Totals& totals) const
+{
+    for (int i=0; i<COUNTER_COUNT; i++)
+        totals.counters[i] += counters[i].load(std::memory_order_relaxed);
+    for (int i=0; i<TIMER_COUNT; i++)
+    {
+        TimerTotals& timer = totals.timers[i];
+        timer.calls += timerCalls[i].load(std::memory_order_relaxed);
+        timer.nanoseconds += timerNanoseconds[i].load(std::memory_order_relaxed);
+        std::uint64_t maxNanoseconds = timerMaxNanoseconds[i].load(std::memory_order_relaxed);
+        if (maxNanoseconds > timer.maxNanoseconds)
+            timer.maxNanoseconds = maxNanoseconds;
+    }
+}
+
+Instrumentation::ScopedTimer::~ScopedTimer()
+{
+    std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - m_start;
+    addTime(m_timer, (std::uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+void Instrumentation::addTime(Timer timer, std::uint64_t nanoseconds)
+{
+    ThreadBlock& block = m_threadBlock;
+    block.timerCalls[timer].store(block.timerCalls[timer].load(std::memory_order_relaxed) + 1,
+                                  std::memory_order_relaxed);
+    block.timerNanoseconds[timer].store(block.timerNanoseconds[timer].load(std::memory_order_relaxed) + nanoseconds,
+                                        std::memory_order_relaxed);
+    if (nanoseconds > block.timerMaxNanoseconds[timer].load(std::memory_order_relaxed))
+        block.timerMaxNanoseconds[timer].store(nanoseconds, std::memory_order_relaxed);
+}
+
+// Return the totals of every thread so far.  Counts made by other threads while this runs may or may not be included.
+Instrumentation::Totals Instrumentation::getTotals()
+{
+    Registry& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    Totals totals = registry.exitedTotals;
+    for (const ThreadBlock* block : registry.liveBlocks)
+        block->addTo(totals);
+    return totals;
+}
+
+// Writes every counter, and the number of calls and the total, average, and longest time of every timer
+void Instrumentation::write(std::ostream& out)
+{
+    if (!isEnabled())
+    {
+        out << "Instrumentation was compiled out of this build" << '\n';
+        return;
+    }
+
+    Totals totals = getTotals();
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::left << std::setw(24) << "Counter" << std::right << std::setw(14) << "Count" << '\n';
+    for (int i=0; i<COUNTER_COUNT; i++)
+        out << std::left << std::setw(24) << getName((Counter) i) << std::right << std::setw(14) << totals.counters[i]
+            << '\n';
+
+    out << '\n' << std::left << std::setw(24) << "Timer" << std::right << std::setw(14) << "Calls"
+        << std::setw(14) << "Total ms" << std::setw(14) << "Average ms" << std::setw(14) << "Max ms" << '\n';
+    out << std::fixed << std::setprecision(3);
+    for (int i=0; i<TIMER_COUNT; i++)
+    {
+        const TimerTotals& timer = totals.timers[i];
+        double averageNanoseconds = (timer.calls > 0) ? (double) timer.nanoseconds / (double) timer.calls : 0;
+        out << std::left << std::setw(24) << getName((Timer) i) << std::right << std::setw(14) << timer.calls
+            << std::setw(14) << (double) timer.nanoseconds / 1e6 << std::setw(14) << averageNanoseconds / 1e6
+            << std::setw(14) << (double) timer.maxNanoseconds / 1e6 << '\n';
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
+
+Instrumentation::Registry& Instrumentation::getRegistry()
+{
+    static Registry registry;
+    return registry;
+}
+
+const char* Instrumentation::getName(Counter counter)
+{
+    return (counter >= 0 && counter < COUNTER_COUNT) ? counterNames[counter] : "Unknown";
+}
+
+const char* Instrumentation::getName(Timer timer)
+{
+    return (timer >= 0 && timer < TIMER_COUNT) ? timerNames[timer] : "Unknown";
+}
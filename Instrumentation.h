@@ -0,0 +1,101 @@
+//
+// Counters and timers around the hot paths, cheap enough to leave on in a live deployment.
+//
+
+#ifndef GEO_REGIONS_INSTRUMENTATION_H
+#define GEO_REGIONS_INSTRUMENTATION_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+// Build with GEO_REGIONS_INSTRUMENTATION set to 0 to compile every probe out.  The class is still there, so the
+// commands that show the totals keep working, and simply report that there is nothing to show.
+#ifndef GEO_REGIONS_INSTRUMENTATION
+#define GEO_REGIONS_INSTRUMENTATION 1
+#endif
+
+// Every thread counts into its own block, so a probe is a couple of plain loads and stores with no locking and no
+// cache lines shared between threads.  The blocks are only added up when someone asks for the totals, and a thread's
+// counts are folded into the totals when it exits, so nothing is lost when the loader's or the rollup's threads end.
+//
+// Probes are placed with the INSTRUMENT_COUNT and INSTRUMENT_TIME macros rather than by calling the class directly,
+// so that they disappear when instrumentation is compiled out.  Timers go around whole operations, e.g., a load or a
+// save, not the recursive steps within them.
+class Instrumentation {
+public:
+    enum Counter { RegionsCreated, ParseFailures, IdLookups, IdLookupMisses, COUNTER_COUNT };
+    enum Timer { LoadTimer, StreamLoadTimer, SaveTimer, SnapshotLoadTimer, SnapshotSaveTimer, RollupTimer,
+                 TIMER_COUNT };
+
+    struct TimerTotals {
+        std::uint64_t   calls = 0;
+        std::uint64_t   nanoseconds = 0;
+        std::uint64_t   maxNanoseconds = 0;
+    };
+
+    struct Totals {
+        std::uint64_t   counters[COUNTER_COUNT] = {};
+        TimerTotals     timers[TIMER_COUNT];
+    };
+
+    // Adds the time from its construction to its destruction to a timer
+    class ScopedTimer {
+    private:
+        Timer                                   m_timer;
+        std::chrono::steady_clock::time_point   m_start;
+
+    public:
+        explicit ScopedTimer(Timer timer) : m_timer(timer), m_start(std::chrono::steady_clock::now()) {}
+        ~ScopedTimer();
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+    };
+
+private:
+    // Only the owning thread writes to a block, so updates don't need atomic read-modify-writes, but they are atomic
+    // stores so that other threads can read them while adding up the totals
+    struct ThreadBlock {
+        std::atomic<std::uint64_t>  counters[COUNTER_COUNT] = {};
+        std::atomic<std::uint64_t>  timerCalls[TIMER_COUNT] = {};
+        std::atomic<std::uint64_t>  timerNanoseconds[TIMER_COUNT] = {};
+        std::atomic<std::uint64_t>  timerMaxNanoseconds[TIMER_COUNT] = {};
+
+        ThreadBlock();
+        ~ThreadBlock();
+        void addTo(Totals& totals) const;
+    };
+
+    struct Registry;
+
+    static thread_local ThreadBlock m_threadBlock;
+
+public:
+    static bool isEnabled() { return GEO_REGIONS_INSTRUMENTATION != 0; }
+
+    static void count(Counter counter, std::uint64_t amount = 1)
+    {
+        std::atomic<std::uint64_t>& value = m_threadBlock.counters[counter];
+        value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+    static void addTime(Timer timer, std::uint64_t nanoseconds);
+
+    static Totals getTotals();
+    static void write(std::ostream& out);
+    static const char* getName(Counter counter);
+    static const char* getName(Timer timer);
+
+private:
+    static Registry& getRegistry();
+};
+
+#if GEO_REGIONS_INSTRUMENTATION
+#define INSTRUMENT_COUNT(counter) Instrumentation::count(Instrumentation::counter)
+#define INSTRUMENT_TIME(timer) Instrumentation::ScopedTimer instrumentationTimer(Instrumentation::timer)
+#else
+#define INSTRUMENT_COUNT(counter) ((void) 0)
+#define INSTRUMENT_TIME(timer) ((void) 0)
+#endif
+
+#endif //GEO_REGIONS_INSTRUMENTATION_H
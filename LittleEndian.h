@@ -0,0 +1,48 @@
+//
+// Reads and writes numbers in the little-endian byte order of the binary file formats.
+//
+
+#ifndef GEO_REGIONS_LITTLE_ENDIAN_H
+#define GEO_REGIONS_LITTLE_ENDIAN_H
+
+#include <cstdint>
+#include <cstring>
+
+// The byte order is spelled out one byte at a time, so the files are the same on any machine and the numbers don't
+// have to be aligned
+class LittleEndian {
+public:
+    static void putU32(char* bytes, std::uint32_t value)
+    {
+        for (int i=0; i<4; i++)
+            bytes[i] = (char) ((value >> (8 * i)) & 0xff);
+    }
+
+    static void putF64(char* bytes, double value)
+    {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        for (int i=0; i<8; i++)
+            bytes[i] = (char) ((bits >> (8 * i)) & 0xff);
+    }
+
+    static std::uint32_t getU32(const char* bytes)
+    {
+        std::uint32_t value = 0;
+        for (int i=0; i<4; i++)
+            value |= (std::uint32_t) (unsigned char) bytes[i] << (8 * i);
+        return value;
+    }
+
+    static double getF64(const char* bytes)
+    {
+        std::uint64_t bits = 0;
+        for (int i=0; i<8; i++)
+            bits |= (std::uint64_t) (unsigned char) bytes[i] << (8 * i);
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+};
+
+#endif //GEO_REGIONS_LITTLE_ENDIAN_H
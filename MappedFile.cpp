@@ -0,0 +1,76 @@
+//
+// Read-only view of a whole data file, memory-mapped where the platform allows it.
+//
+
+#include "MappedFile.h"
+
+#include <fstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& filename)
+{
+    m_isOpen = map(filename) || read(filename);
+}
+
+MappedFile::~MappedFile()
+{
+#ifndef _WIN32
+    if (m_isMapped)
+        munmap((void*) m_data, m_size);
+#endif
+}
+
+// Maps the file read-only.  Empty files can't be mapped, so they are left to read(), which handles them trivially.
+//
+// Return true if the file was mapped, otherwise false.
+bool MappedFile::map(const std::string& filename)
+{
+#ifndef _WIN32
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat fileStatus;
+    if (fstat(fd, &fileStatus) == 0 && fileStatus.st_size > 0)
+    {
+        void* address = mmap(nullptr, (std::size_t) fileStatus.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED)
+        {
+            madvise(address, (std::size_t) fileStatus.st_size, MADV_SEQUENTIAL);
+            m_data = (const char*) address;
+            m_size = (std::size_t) fileStatus.st_size;
+            m_isMapped = true;
+        }
+    }
+    ::close(fd);
+#endif
+    return m_isMapped;
+}
+
+// Reads the whole file into one buffer, for when it can't be mapped
+//
+// Return true if the file could be opened, otherwise false.
+bool MappedFile::read(const std::string& filename)
+{
+    std::ifstream inputStream(filename, std::ios::binary | std::ios::ate);
+    if (!inputStream.is_open())
+        return false;
+
+    std::streamoff size = inputStream.tellg();
+    if (size > 0)
+    {
+        m_buffer.resize((std::size_t) size);
+        inputStream.seekg(0);
+        inputStream.read(m_buffer.data(), size);
+        m_buffer.resize((std::size_t) inputStream.gcount());
+    }
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+    return true;
+}
@@ -0,0 +1,38 @@
+//
+// Read-only view of a whole data file, memory-mapped where the platform allows it.
+//
+
+#ifndef GEO_REGIONS_MAPPED_FILE_H
+#define GEO_REGIONS_MAPPED_FILE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Maps a file into memory so that it can be parsed in place.  On platforms without mmap, or if mapping fails, the
+// file is read into a single buffer instead, so callers always see the contents as one contiguous block of text.
+class MappedFile {
+private:
+    const char*         m_data = nullptr;
+    std::size_t         m_size = 0;
+    bool                m_isOpen = false;
+    bool                m_isMapped = false;
+    std::vector<char>   m_buffer;
+
+public:
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool isOpen() const { return m_isOpen; }
+    bool isMapped() const { return m_isMapped; }
+    std::size_t size() const { return m_size; }
+    std::string_view getText() const { return std::string_view(m_data, m_size); }
+
+private:
+    bool map(const std::string& filename);
+    bool read(const std::string& filename);
+};
+
+#endif //GEO_REGIONS_MAPPED_FILE_H
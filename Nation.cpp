@@ -4,7 +4,12 @@
 
 #include "Nation.h"
 
-Nation::Nation(const std::string data[]) : Region(NationType, data)
+Nation::Nation(const std::string_view data[]) : Region(NationType, data)
+{
+    validate();
+}
+
+Nation::Nation(std::string_view name, unsigned int population, double area) : Region(NationType, name, population, area)
 {
     validate();
 }
@@ -8,11 +8,15 @@
 #include "Region.h"
 
 #include <string>
+#include <string_view>
 
 class Nation : public Region
 {
 public:
-    Nation(const std::string data[]);
+    static constexpr RegionType regionType = NationType;
+
+    Nation(const std::string_view data[]);
+    Nation(std::string_view name, unsigned int population, double area);
 };
 
 
@@ -5,8 +5,8 @@
 #include "NationUserInterface.h"
 #include "Menu.h"
 
-NationUserInterface::NationUserInterface(Region* contextRegion) :
-        UserInterface(contextRegion)
+NationUserInterface::NationUserInterface(Region* contextRegion, RegionJournal* journal) :
+        UserInterface(contextRegion, journal)
 {
 
 }
@@ -24,6 +24,7 @@ void NationUserInterface::setupMenu()
     m_menu->addOption("L", "List all states in this nation");
     m_menu->addOption("E", "Edit a state");
     m_menu->addOption("D", "Delete a state");
+    m_menu->addOption("R", "Relocate a state to another nation");
     m_menu->addOption("P", "Print a report containing all states in this nation");
     m_menu->addOption("M", "Move into the context of a state");
 }
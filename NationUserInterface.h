@@ -10,7 +10,7 @@
 class NationUserInterface : public UserInterface
 {
 public:
-    NationUserInterface(Region* contextRegion);
+    NationUserInterface(Region* contextRegion, RegionJournal* journal = nullptr);
 
     Region::RegionType getSubRegionType();
     void setupMenu();
@@ -0,0 +1,158 @@
+//
+// Parses the top-level sub-regions of a data file on several threads at once.
+//
+
+#include "ParallelRegionLoader.h"
+#include "Region.h"
+#include "RegionArena.h"
+#include "World.h"
+#include "Utils.h"
+
+#include <climits>
+#include <memory>
+#include <thread>
+
+// Parses a region from the front of text and then its sub-regions, advancing text past everything consumed
+//
+// Return the region, or nullptr if the first line isn't a valid region.
+Region* ParallelRegionLoader::parse(std::string_view& text, bool useArena, unsigned int threadCount)
+{
+    Region* root = nullptr;
+    std::string_view line = nextLine(text);
+    if (!line.empty())
+        root = Region::create(line);
+    if (root == nullptr)
+        return nullptr;
+
+    World* world = (useArena && root->getType() == Region::WorldType) ? static_cast<World*>(root) : nullptr;
+
+    std::vector<Chunk> chunks = findChunks(text);
+    unsigned long long regionCount = 0;
+    for (Chunk& chunk : chunks)
+    {
+        chunk.firstId = (unsigned int) (Region::m_nextId + regionCount);
+        regionCount += chunk.regionCount;
+    }
+
+    if (threadCount == 0)
+        threadCount = std::thread::hardware_concurrency();
+    if (threadCount > chunks.size())
+        threadCount = (unsigned int) chunks.size();
+
+    bool allParsed = false;
+    if (threadCount > 1 && Region::m_nextId + regionCount < UINT_MAX)
+    {
+        // Make room in the registry up front, so the threads only ever write to their own entries
+        unsigned int endId = (unsigned int) (Region::m_nextId + regionCount);
+        Region::reserveRegistry(endId);
+
+        std::vector<std::unique_ptr<RegionArena>> arenas;
+        for (unsigned int i=0; world != nullptr && i<threadCount; i++)
+            arenas.emplace_back(new RegionArena());
+
+        std::atomic<std::size_t> nextChunk(0);
+        std::vector<std::thread> threads;
+        for (unsigned int i=1; i<threadCount; i++)
+            threads.emplace_back(parseChunks, std::ref(chunks), std::ref(nextChunk),
+                                 arenas.empty() ? nullptr : arenas[i].get());
+        parseChunks(chunks, nextChunk, arenas.empty() ? nullptr : arenas[0].get());
+        for (std::thread& thread : threads)
+            thread.join();
+
+        // A top-level subtree the root can't contain is skipped by the sequential parser, so it can't be used here
+        allParsed = true;
+        for (const Chunk& chunk : chunks)
+            allParsed = allParsed && chunk.isParsed && Region::canContain(root->getType(), chunk.region->getType());
+
+        if (allParsed)
+        {
+            for (const Chunk& chunk : chunks)
+                root->addSubregion(chunk.region);
+            for (std::unique_ptr<RegionArena>& arena : arenas)
+                world->adoptArena(std::move(arena));
+            Region::m_nextId = endId;
+            text = std::string_view();
+        }
+        else
+        {
+            for (const Chunk& chunk : chunks)
+                delete chunk.region;
+        }
+    }
+
+    if (!allParsed)
+        root->parseChildren(text, world != nullptr ? world->useArena() : nullptr);
+
+    return root;
+}
+
+// Finds the text of each top-level sub-region, up to the delimiter that ends the root's list of sub-regions, by
+// following the nesting of the delimiters.  Lines without a comma can never be regions, so they are skipped just as
+// the sequential parser skips them.
+std::vector<ParallelRegionLoader::Chunk> ParallelRegionLoader::findChunks(std::string_view text)
+{
+    std::vector<Chunk> chunks;
+    unsigned int depth = 0;
+    bool done = false;
+    while (!text.empty() && !done)
+    {
+        const char* lineStart = text.data();
+        std::string_view line = nextLine(text);
+        if (line == Region::regionDelimiter)
+        {
+            if (depth == 0)
+            {
+                done = true;
+            }
+            else if (--depth == 0)
+            {
+                Chunk& chunk = chunks.back();
+                chunk.text = std::string_view(chunk.text.data(), text.data() - chunk.text.data());
+            }
+        }
+        else if (line.find(',') != std::string_view::npos)
+        {
+            if (depth++ == 0)
+            {
+                chunks.emplace_back();
+                chunks.back().text = std::string_view(lineStart, 0);
+            }
+            chunks.back().regionCount++;
+        }
+    }
+
+    // A subtree that runs to the end of the file without its closing delimiter takes the rest of the text
+    if (depth > 0)
+    {
+        Chunk& chunk = chunks.back();
+        chunk.text = std::string_view(chunk.text.data(), text.data() + text.size() - chunk.text.data());
+    }
+
+    return chunks;
+}
+
+// Parses chunks until there are none left.  Each thread takes the next unclaimed chunk, so a few very large subtrees
+// don't hold up the rest.
+void ParallelRegionLoader::parseChunks(std::vector<Chunk>& chunks, std::atomic<std::size_t>& nextChunk,
+                                       RegionArena* arena)
+{
+    for (std::size_t i = nextChunk++; i < chunks.size(); i = nextChunk++)
+        parseChunk(chunks[i], arena);
+}
+
+// Parses one subtree with the ids reserved for it.  It only counts as parsed if it used up exactly its text and its
+// ids, which is what guarantees the same result as a sequential load.
+void ParallelRegionLoader::parseChunk(Chunk& chunk, RegionArena* arena)
+{
+    Region::m_useReservedIds = true;
+    Region::m_nextReservedId = chunk.firstId;
+
+    std::string_view text = chunk.text;
+    chunk.region = Region::create(nextLine(text), arena);
+    if (chunk.region != nullptr)
+        chunk.region->parseChildren(text, arena);
+
+    chunk.isParsed = (chunk.region != nullptr && text.empty() &&
+                      Region::m_nextReservedId == chunk.firstId + chunk.regionCount);
+    Region::m_useReservedIds = false;
+}
@@ -0,0 +1,42 @@
+//
+// Parses the top-level sub-regions of a data file on several threads at once.
+//
+
+#ifndef GEO_REGIONS_PARALLEL_REGION_LOADER_H
+#define GEO_REGIONS_PARALLEL_REGION_LOADER_H
+
+#include <atomic>
+#include <string_view>
+#include <vector>
+
+class Region;
+class RegionArena;
+
+// Loads a data file in two passes.  The first pass only looks at the ^^^ delimiters to find where each top-level
+// sub-region (e.g., each nation of the world) begins and ends.  The second pass parses those subtrees on worker
+// threads, each with its own block of ids and, if asked for, its own arena, and then attaches them to the root in
+// file order.
+//
+// The result is exactly what a sequential load would build, including the ids.  If a subtree doesn't parse the way
+// the first pass expected, which only happens with malformed lines, the parallel results are thrown away and the
+// sub-regions are parsed one after another instead.
+class ParallelRegionLoader {
+private:
+    struct Chunk {
+        std::string_view    text;
+        unsigned int        regionCount = 0;    // number of region lines the first pass found
+        unsigned int        firstId = 0;
+        Region*             region = nullptr;
+        bool                isParsed = false;
+    };
+
+public:
+    static Region* parse(std::string_view& text, bool useArena, unsigned int threadCount);
+
+private:
+    static std::vector<Chunk> findChunks(std::string_view text);
+    static void parseChunks(std::vector<Chunk>& chunks, std::atomic<std::size_t>& nextChunk, RegionArena* arena);
+    static void parseChunk(Chunk& chunk, RegionArena* arena);
+};
+
+#endif //GEO_REGIONS_PARALLEL_REGION_LOADER_H
@@ -9,16 +9,158 @@
 #include "State.h"
 #include "County.h"
 #include "City.h"
-
+#include "Instrumentation.h"
+#include "MappedFile.h"
+#include "RegionSnapshot.h"
+#include "BufferedWriter.h"
+#include "RegionArena.h"
+#include "ParallelRegionLoader.h"
+#include "RegionEpoch.h"
+#include "RegionRollup.h"
+#include "RegionVisitor.h"
+
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
+#include <memory>
+#include <fstream>
+#include <cstdio>
 
-const std::string regionDelimiter = "^^^";
 const int TAB_SIZE = 4;
+
+namespace
+{
+    // Writes each region's id and name on a line of its own, as list() does
+    struct ListWriter : RegionVisitor<ListWriter> {
+        std::ostream& out;
+
+        explicit ListWriter(std::ostream& out) : out(out) {}
+
+        bool enter(const Region& region, unsigned int)
+        {
+            out << '\n' << region.getId() << " " << region.getName() << ":" << '\n';
+            return true;
+        }
+    };
+
+    // Writes each region's rolled-up totals, indented by its level, as display() does
+    struct DisplayWriter : RegionVisitor<DisplayWriter> {
+        std::ostream&       out;
+        const RegionRollup& rollup;
+        unsigned int        displayLevel;
+        bool                showChild;
+        std::size_t         nextRow = 0;    // the rollup row of the next region, unless the hierarchy has changed
+
+        DisplayWriter(std::ostream& out, const RegionRollup& rollup, unsigned int displayLevel, bool showChild) :
+                out(out), rollup(rollup), displayLevel(displayLevel), showChild(showChild) {}
+
+        bool enter(const Region& region, unsigned int depth)
+        {
+            std::size_t row = rollup.findRow(region, nextRow);
+            nextRow = row + 1;
+            writeLine(out, region, displayLevel + depth, rollup.getTotalsAt(row));
+            return showChild;
+        }
+
+        static void writeLine(std::ostream& out, const Region& region, unsigned int level,
+                              const RegionRollup::Totals& totals)
+        {
+            if (level>0)
+            {
+                out << std::setw(level * TAB_SIZE) << " ";
+            }
+
+            out << std::setw(6) << region.getId() << "  "
+                << region.getName() << ", population="
+                << totals.population
+                << ", area=" << totals.area
+                << ", density=" << totals.density << '\n';
+        }
+    };
+
+    // Writes each region as a line of a data file, with a delimiter after its sub-regions
+    struct DataFileWriter : RegionVisitor<DataFileWriter> {
+        BufferedWriter& writer;
+
+        explicit DataFileWriter(BufferedWriter& writer) : writer(writer) {}
+
+        bool enter(const Region& region, unsigned int)
+        {
+            writer.writeUnsigned(region.getType());
+            writer.write(',');
+            writer.write(region.getName());
+            writer.write(',');
+            writer.writeUnsigned(region.getPopulation());
+            writer.write(',');
+            writer.writeDouble(region.getArea());
+            writer.write('\n');
+            return true;
+        }
+
+        void leave(const Region&, unsigned int)
+        {
+            writer.write(Region::regionDelimiter);
+            writer.write('\n');
+        }
+    };
+}
 unsigned int Region::m_nextId = 0;
+std::atomic<Region::RegistryTable*> Region::m_registry(nullptr);
+std::atomic<std::uint64_t> Region::m_changeCount(0);
+
+// The registry's slots, which are looked up without locks, so they are atomic
+struct Region::RegistryTable {
+    std::size_t                                 size;
+    std::unique_ptr<std::atomic<Region*>[]>     slots;
+
+    explicit RegistryTable(std::size_t size) : size(size), slots(new std::atomic<Region*>[size])
+    {
+        for (std::size_t i=0; i<size; i++)
+            slots[i].store(nullptr, std::memory_order_relaxed);
+    }
+};
+thread_local bool Region::m_useReservedIds = false;
+thread_local unsigned int Region::m_nextReservedId = 0;
+
+// The hierarchy the menus and data files describe, checked when this is compiled
+static_assert(Region::canContain<World, Nation>() && Region::canContain<Nation, State>() &&
+              Region::canContain<State, County>() && Region::canContain<State, City>() &&
+              Region::canContain<County, City>(), "A region can't contain the regions it is made of");
+static_assert(!Region::canContain<World, State>() && !Region::canContain<County, State>() &&
+              !Region::canContain<City, City>() && !Region::canContain<Nation, World>(),
+              "A region can contain regions it isn't made of");
+
+// Loads a region and all of its sub-regions from a data file.  The file is memory-mapped and parsed in place, so the
+// only allocations are for the regions themselves.
+//
+// Return the region, or nullptr if the file couldn't be opened or its first line isn't a valid region.  If fileFound
+// is provided, it is set to whether the file could be opened.  If useArena is true and the file holds a world, all of
+// the world's sub-regions are allocated from an arena owned by the world.
+//
+// If threadCount is anything but 1, the top-level sub-regions are parsed on that many threads (0 means one per core),
+// with the same result as parsing them one after another.
+Region* Region::load(const std::string& filename, bool* fileFound, bool useArena, unsigned int threadCount)
+{
+    INSTRUMENT_TIME(LoadTimer);
+    Region* region = nullptr;
+    MappedFile file(filename);
+    if (fileFound != nullptr)
+        *fileFound = file.isOpen();
+
+    if (file.isOpen())
+    {
+        std::string_view text = file.getText();
+        if (threadCount != 1)
+            region = ParallelRegionLoader::parse(text, useArena, threadCount);
+        else
+            region = parse(text, useArena);
+    }
+    return region;
+}
 
 Region* Region::create(std::istream &in)
 {
+    INSTRUMENT_TIME(StreamLoadTimer);
     Region* region = nullptr;
     std::string line;
     std::getline(in, line);
@@ -30,33 +172,42 @@ Region* Region::create(std::istream &in)
     }
     return region;
 }
-Region* Region::create(const std::string& data)
+Region* Region::create(std::string_view data, RegionArena* arena)
 {
     Region* region = nullptr;
-    std::string regionData;
-    unsigned long commaPos = (int) data.find(",");
-    if (commaPos != std::string::npos)
+    std::size_t commaPos = data.find(',');
+    if (commaPos != std::string_view::npos)
     {
-        std::string regionTypeStr = data.substr(0,commaPos);
-        regionData = data.substr(commaPos+1);
+        std::string_view regionTypeStr = data.substr(0,commaPos);
+        std::string_view regionData = data.substr(commaPos+1);
 
         bool isValid;
-        RegionType regionType = (RegionType) convertStringToInt(regionTypeStr, &isValid);
+        RegionType regionType = (RegionType) parseInt(regionTypeStr, &isValid);
 
         if (isValid)
         {
-            region = create(regionType, regionData);
+            region = create(regionType, regionData, arena);
+        }
+        else
+        {
+            INSTRUMENT_COUNT(ParseFailures);
         }
 
     }
+    else
+    {
+        INSTRUMENT_COUNT(ParseFailures);
+    }
 
     return region;
 }
 
-Region* Region::create(RegionType regionType, const std::string& data)
+// Creates a region of the given type from its name, population, and area fields.  If an arena is provided, the region
+// is allocated from it, except for a world, which always owns its own memory.
+Region* Region::create(RegionType regionType, std::string_view data, RegionArena* arena)
 {
     Region* region = nullptr;
-    std::string fields[3];
+    std::string_view fields[3];
     if (split(data, ',', fields, 3)) {
 
         // Create the region based on type
@@ -65,16 +216,16 @@ Region* Region::create(RegionType regionType, const std::string& data)
                 region = new World();
                 break;
             case NationType:
-                region = new Nation(fields);
+                region = new (arena) Nation(fields);
                 break;
             case StateType:
-                region=new State(fields);
+                region = new (arena) State(fields);
                 break;
             case CountyType:
-                region=new County(fields);
+                region = new (arena) County(fields);
                 break;
             case CityType:
-                region=new City(fields);
+                region = new (arena) City(fields);
                 break;
        // DONE: Add cases for State, County, and City
             default:
@@ -88,133 +239,338 @@ Region* Region::create(RegionType regionType, const std::string& data)
         }
     }
 
+    if (region != nullptr)
+        INSTRUMENT_COUNT(RegionsCreated);
+    else
+        INSTRUMENT_COUNT(ParseFailures);
     return region;
 }
 
-std::string Region::regionLabel(RegionType regionType)
+// Creates a region from values that have already been parsed, e.g., out of a snapshot
+Region* Region::create(RegionType regionType, std::string_view name, unsigned int population, double area,
+                       RegionArena* arena)
 {
-    std::string label = "Unknown";
-    switch (regionType)
-    {
-        case Region::WorldType:
-            label = "World";
+    Region* region = nullptr;
+    switch (regionType) {
+        case WorldType:
+            region = new World(name, population, area);
             break;
-        case Region::NationType:
-            label = "Nation";
+        case NationType:
+            region = new (arena) Nation(name, population, area);
             break;
-        case Region::StateType:
-            label = "State";
+        case StateType:
+            region = new (arena) State(name, population, area);
             break;
-        case Region::CountyType:
-            label = "County";
+        case CountyType:
+            region = new (arena) County(name, population, area);
             break;
-        case Region::CityType:
-            label = "City";
+        case CityType:
+            region = new (arena) City(name, population, area);
             break;
         default:
             break;
     }
-    return label;
+
+    if (region != nullptr && !region->getIsValid()) {
+        delete region;
+        region = nullptr;
+    }
+
+    if (region != nullptr)
+        INSTRUMENT_COUNT(RegionsCreated);
+    return region;
+}
+
+// Loads a region and all of its sub-regions from a binary snapshot written by saveSnapshot.  Regions keep the ids
+// they had when the snapshot was saved, unless one of those ids is already taken by a live region.  If useArena is
+// true and the snapshot holds a world, the world's sub-regions are allocated from an arena, as with load.
+//
+// Return the region, or nullptr if the file couldn't be opened or isn't a valid snapshot.  If fileFound is provided,
+// it is set to whether the file could be opened.  If generation is provided, it is set to the generation the snapshot
+// was saved with.
+Region* Region::loadSnapshot(const std::string& filename, bool* fileFound, bool useArena, std::uint32_t* generation)
+{
+    INSTRUMENT_TIME(SnapshotLoadTimer);
+    Region* region = nullptr;
+    MappedFile file(filename);
+    if (fileFound != nullptr)
+        *fileFound = file.isOpen();
+
+    if (file.isOpen())
+        region = RegionSnapshot::read(file.getText(), useArena, generation);
+    return region;
+}
+
+// Creates a region that keeps the id it had before, e.g., in a snapshot or journal, if no live region has taken that
+// id since and the id is plausible for the number of regions being read (see isPlausibleId)
+Region* Region::createWithId(unsigned int id, RegionType regionType, std::string_view name, unsigned int population,
+                             double area, RegionArena* arena, std::size_t regionCount)
+{
+    unsigned int nextId = m_nextId;
+    bool keepId = (findById(id) == nullptr && id != UINT32_MAX && isPlausibleId(id, regionCount));
+    if (keepId)
+        m_nextId = id;
+
+    Region* region = create(regionType, name, population, area, arena);
+
+    if (keepId)
+        m_nextId = (nextId > id) ? nextId : id + 1;
+    return region;
+}
+
+std::string Region::regionLabel(RegionType regionType)
+{
+    return std::string(regionLabelView(regionType));
 }
 
 Region::Region() { }
 
-Region::Region(RegionType type, const std::string data[]) :
-        m_id(getNextId()), m_regionType(type), m_isValid(true)
+Region::Region(RegionType type, const std::string_view data[]) :
+        m_id(getNextId()), m_regionType(type), m_createdName(data[0]), m_isValid(true)
 {
-    m_name = data[0];
-    m_population = convertStringToUnsignedInt(data[1], &m_isValid);
+    registerRegion();
+    unsigned int population = parseUnsignedInt(data[1], &m_isValid);
+    m_population.store(population, std::memory_order_relaxed);
+    m_totalPopulation.store(population, std::memory_order_relaxed);
     if (m_isValid)
-        m_area = convertStringToDouble(data[2], &m_isValid);
+        m_area.store(parseDouble(data[2], &m_isValid), std::memory_order_relaxed);
+}
+
+Region::Region(RegionType type, std::string_view name, unsigned int population, double area) :
+        m_id(getNextId()), m_regionType(type), m_createdName(name), m_population(population),
+        m_totalPopulation(population), m_area(area), m_isValid(true)
+{
+    registerRegion();
 }
 
 Region::~Region()
 {
-    delete[] m_subregion;
-    // DONE: cleanup any dynamically allocated objects
+    unregisterRegion();
+    deleteSubRegions();
+
+    const std::string* name = m_name.load(std::memory_order_relaxed);
+    if (name != &m_createdName)
+        delete name;
 }
 
-std::string Region::getRegionLabel() const
+// Every region is allocated with a small header in front of it that records where its memory came from, so that
+// delete works the same way for any region: it always runs the destructor, but only gives the memory back to the
+// heap if it came from there.  Memory from an arena is released when the arena is.
+void* Region::operator new(std::size_t size)
 {
-    return regionLabel(getType());
+    char* memory = (char*) ::operator new(ALLOCATION_HEADER_SIZE + size);
+    *memory = HEAP_ALLOCATED;
+    return memory + ALLOCATION_HEADER_SIZE;
 }
 
-unsigned int Region::computeTotalPopulation()
+void* Region::operator new(std::size_t size, RegionArena* arena)
 {
-    long int sum=m_population;
-    for(int i=0;i<subCount;i++){
-        sum+=m_subregion[i]->computeTotalPopulation();//recursive!
+    if (arena == nullptr)
+        return operator new(size);
+
+    char* memory = (char*) arena->allocate(ALLOCATION_HEADER_SIZE + size);
+    *memory = ARENA_ALLOCATED;
+    return memory + ALLOCATION_HEADER_SIZE;
+}
+
+void Region::operator delete(void* region)
+{
+    if (region != nullptr)
+    {
+        char* memory = (char*) region - ALLOCATION_HEADER_SIZE;
+        if (*memory == HEAP_ALLOCATED)
+            ::operator delete(memory);
     }
-    return sum;
-    // DONE: implement computeTotalPopulation, such that the result is m_population + the total population for all sub-regions
 }
 
-void Region::list(std::ostream& out)
+void Region::operator delete(void* region, RegionArena*)
+{
+    operator delete(region);
+}
+
+// Return true if the region or any of its sub-regions was allocated from an arena, so it can't outlive the world
+// that owns the arena
+bool Region::hasArenaRegions() const
 {
-    out << std::endl;
-    out <<getId()<<" "<< getName() << ":" << std::endl;
+    if (*((const char*) this - ALLOCATION_HEADER_SIZE) == ARENA_ALLOCATED)
+        return true;
+    for (const Region* subRegion : m_subRegions)
+    {
+        if (subRegion->hasArenaRegions())
+            return true;
+    }
+    return false;
+}
 
-    // DONE: implement the loop in the list method
-    for(int i=0;i<subCount;i++){
-        m_subregion[i]->list(out);
+// Return a copy of a region that has no parent, and all of its sub-regions, on the heap, with the same ids.  The
+// region itself is disposed of as by RegionDeleter, so readers that are still looking at it can finish.
+Region* Region::copyToHeap()
+{
+    unregisterSubtree();
+    Region* copy = copySubtree();
+    RegionEpoch::retire(this);
+    return copy;
+}
 
+Region* Region::copySubtree() const
+{
+    Region* copy = createWithId(m_id, m_regionType, getName(), getPopulation(), getArea());
+    if (copy != nullptr)
+    {
+        for (const Region* subRegion : m_subRegions)
+            copy->addSubregion(subRegion->copySubtree());
     }
-    //out<<regionDelimiter<<std::endl;
-    // foreach subregion, print out
-    //      id    name
+    return copy;
 }
 
-void Region::display(std::ostream& out, unsigned int displayLevel, bool showChild)
+// Return the region at the top of this region's hierarchy
+const Region* Region::getRoot() const
 {
-    if (displayLevel>0)
+    const Region* root = this;
+    for (const Region* parent = getParent(); parent != nullptr; parent = parent->getParent())
+        root = parent;
+    return root;
+}
+
+// Return a sentence that says why moveTo couldn't move this region under the new parent
+std::string Region::describeMoveFailure(MoveFailure failure, const Region& newParent) const
+{
+    switch (failure)
     {
-        out << std::setw(displayLevel * TAB_SIZE) << " ";
+        case MoveFromTop:
+            return "A " + getRegionLabel() + " at the top of its hierarchy can't be moved";
+        case MoveToWrongType:
+            return "A " + newParent.getRegionLabel() + " can't contain a " + getRegionLabel();
+        case MoveUnderItself:
+            return "Can't move a region under itself or one of its sub-regions";
+        case MoveToOtherHierarchy:
+            return "Can't move a region to another hierarchy";
+        default:
+            return "";
     }
+}
+
+// Deletes all of the sub-regions, which in turn delete theirs
+void Region::deleteSubRegions()
+{
+    for (Region* subRegion : m_subRegions)
+        delete subRegion;
+    m_subRegions.clear();
+}
+
+std::string Region::getRegionLabel() const
+{
+    return regionLabel(getType());
+}
 
-    unsigned totalPopulation = computeTotalPopulation();
-    double area = getArea();
-    double density = (double) totalPopulation / area;
+// Publishes the new name, and retires the old one if it wasn't the one the region was created with
+void Region::setName(const std::string& name)
+{
+    const std::string* oldName = m_name.load(std::memory_order_relaxed);
+    m_name.store(new std::string(name), std::memory_order_release);
+    if (oldName != &m_createdName)
+        RegionEpoch::retire(const_cast<std::string*>(oldName));
+    noteChange();
+}
 
-    // DONE: compute the totalPopulation using a method
+void Region::setPopulation(unsigned int population)
+{
+    adjustTotalPopulation((long long) population - getPopulation());
+    m_population.store(population, std::memory_order_relaxed);
+}
 
-    out << std::setw(6) << getId() << "  "
-        << getName() << ", population="
-        << totalPopulation
-        << ", area=" << area
-        << ", density=" << density << std::endl;
+// The total is maintained incrementally by setPopulation, addSubregion, and removeSubregion, so this is O(1)
+unsigned int Region::computeTotalPopulation()
+{
+    return m_totalPopulation.load(std::memory_order_relaxed);
+}
+
+void Region::list(std::ostream& out)
+{
+    ListWriter(out).visit(*this);
+}
 
-    if (showChild)
+// Displays this region, and if showChild is true, all of its sub-regions, with the population, area, and density of
+// each one rolled up from its sub-regions
+void Region::display(std::ostream& out, unsigned int displayLevel, bool showChild)
+{
+    // The total population is kept up to date, so one line for a region with its own area needs no rollup
+    if (!showChild && getArea() > 0)
     {
-        // DONE: implement loop in display method
-        for(int i=0;i<subCount;i++){
-            m_subregion[i]->display(out,displayLevel+1,showChild);
-        }
-        // foreach subregion
-        //      display that subregion at displayLevel+1 with the same showChild value
+        RegionRollup::Totals totals;
+        totals.population = m_totalPopulation.load(std::memory_order_relaxed);
+        totals.area = getArea();
+        totals.density = (double) totals.population / totals.area;
+        DisplayWriter::writeLine(out, *this, displayLevel, totals);
+        return;
     }
+
+    RegionRollup rollup(*this, showChild ? 0 : 1);
+    display(out, displayLevel, showChild, rollup);
+}
+
+void Region::display(std::ostream& out, unsigned int displayLevel, bool showChild, const RegionRollup& rollup)
+{
+    DisplayWriter(out, rollup, displayLevel, showChild).visit(*this);
 }
 
 void Region::save(std::ostream& out)
 {
-    out << getType()
-        << "," << getName()
-        << "," << getPopulation()
-        << "," << getArea()
-        << std::endl;
+    INSTRUMENT_TIME(SaveTimer);
+    BufferedWriter writer(out);
+    save(writer);
+    writer.flush();
+}
 
-    // DONE: implement loop in save method to save each sub-region
-    for(int i=0;i<subCount;i++){
-        m_subregion[i]->save(out);
+// Saves this region and all of its sub-regions to a data file, replacing it if it exists.  The output is buffered
+// and written in large chunks.  If syncToDisk is true, the file is synced to disk once, after everything is written.
+//
+// Return true if the whole file was written, otherwise false with the reason in error, if provided.
+bool Region::save(const std::string& filename, bool syncToDisk, std::string* error)
+{
+    INSTRUMENT_TIME(SaveTimer);
+    BufferedWriter writer(filename);
+    save(writer);
+    bool saved = writer.close(syncToDisk);
+    if (!saved && error != nullptr)
+        *error = writer.getError();
+    return saved;
+}
+
+void Region::save(BufferedWriter& writer)
+{
+    DataFileWriter(writer).visit(*this);
+}
+
+// Writes this region and all of its sub-regions to a binary snapshot file, replacing it if it exists.  The generation
+// is saved with it, so that a journal of the changes made after the snapshot can be matched to it.
+//
+// Return true if the whole snapshot was written, otherwise false.
+bool Region::saveSnapshot(const std::string& filename, std::uint32_t generation)
+{
+    // The snapshot is written next to the old one and then renamed over it, so a crash part way through never
+    // leaves a broken snapshot behind
+    INSTRUMENT_TIME(SnapshotSaveTimer);
+    std::string temporaryFile = filename + ".tmp";
+    bool saved;
+    {
+        std::ofstream outputStream(temporaryFile, std::ios::binary | std::ios::trunc);
+        saved = outputStream.is_open() && RegionSnapshot::write(*this, outputStream, generation);
     }
-    // foreach subregion,
-    //      save that region
 
-    out << regionDelimiter << std::endl;
+#ifdef _WIN32
+    if (saved)
+        std::remove(filename.c_str());
+#endif
+    saved = saved && std::rename(temporaryFile.c_str(), filename.c_str()) == 0;
+    if (!saved)
+        std::remove(temporaryFile.c_str());
+    return saved;
 }
 
 void Region::validate()
 {
-    m_isValid = (m_area!=UnknownRegionType && m_name!="" && m_area>=0);
+    m_isValid = (getArea()!=UnknownRegionType && getName()!="" && getArea()>=0);
 }
 
 void Region::loadChildren(std::istream& in)
@@ -228,6 +584,10 @@ void Region::loadChildren(std::istream& in)
         {
             done = true;
         }
+        else if (isMisplaced(line))
+        {
+            skipSubtree(in);
+        }
         else
         {
             Region* child = create(line);
@@ -241,33 +601,394 @@ void Region::loadChildren(std::istream& in)
     }
 }
 
+// Parses a region from the front of text and then its sub-regions, advancing text past everything consumed
+Region* Region::parse(std::string_view& text, bool useArena)
+{
+    Region* region = nullptr;
+    std::string_view line = nextLine(text);
+    if (!line.empty())
+    {
+        region = create(line);
+        if (region!= nullptr)
+        {
+            RegionArena* arena = nullptr;
+            if (useArena && region->getType()==WorldType)
+                arena = static_cast<World*>(region)->useArena();
+            region->parseChildren(text, arena);
+        }
+    }
+    return region;
+}
+
+// The in-place counterpart of loadChildren
+void Region::parseChildren(std::string_view& text, RegionArena* arena)
+{
+    bool done = false;
+    while (!text.empty() && !done)
+    {
+        std::string_view line = nextLine(text);
+        if (line==regionDelimiter)
+        {
+            done = true;
+        }
+        else if (isMisplaced(line))
+        {
+            skipSubtree(text);
+        }
+        else
+        {
+            Region* child = create(line, arena);
+            if (child!= nullptr)
+            {
+                addSubregion(child);
+                child->parseChildren(text, arena);
+            }
+        }
+    }
+}
+
+// Return true if the line is a region of a known type that this region can't contain, e.g., a state in a county.
+// Such a region is rejected before anything is created for it, and so are its sub-regions.
+bool Region::isMisplaced(std::string_view line) const
+{
+    std::size_t commaPos = line.find(',');
+    bool isValid = (commaPos != std::string_view::npos);
+    int regionType = isValid ? parseInt(line.substr(0, commaPos), &isValid) : 0;
+    bool misplaced = (isValid && regionType > UnknownRegionType && regionType < (int) REGION_TYPE_COUNT &&
+                      !canContain(getType(), (RegionType) regionType));
+    if (misplaced)
+        INSTRUMENT_COUNT(ParseFailures);
+    return misplaced;
+}
+
+// Skips the sub-regions of a region that was rejected, up to the delimiter that closes its list.  The nesting is
+// followed the same way ParallelRegionLoader follows it: lines with a comma open a list, and delimiters close one.
+void Region::skipSubtree(std::istream& in)
+{
+    std::string line;
+    unsigned int depth = 1;
+    while (depth > 0 && std::getline(in, line))
+    {
+        if (line == regionDelimiter)
+            depth--;
+        else if (line.find(',') != std::string::npos)
+            depth++;
+    }
+}
+
+void Region::skipSubtree(std::string_view& text)
+{
+    unsigned int depth = 1;
+    while (depth > 0 && !text.empty())
+    {
+        std::string_view line = nextLine(text);
+        if (line == regionDelimiter)
+            depth--;
+        else if (line.find(',') != std::string_view::npos)
+            depth++;
+    }
+}
+
 unsigned int Region::getNextId()
 {
+    if (m_useReservedIds)
+        return m_nextReservedId++;
+
     if (m_nextId==UINT32_MAX)
         m_nextId=1;
 
     return m_nextId++;
 }
-void Region::addSubregion(Region* region){
-    subCount++;
-    Region* holder[subCount];
-    for(int i=0;i<subCount-1;i++){
-        holder[i]=m_subregion[i];
+// Takes ownership of the region, along with all of its sub-regions, and adds its population to the totals up the
+// ancestor chain.  A region of a type this region can't contain is disposed of instead, the same way a RegionPtr
+// would dispose of it.
+//
+// Return true if the region was added.
+bool Region::addSubregion(Region* region){
+    bool added = (region != nullptr && canContain(getType(), region->getType()));
+    if (added)
+    {
+        region->m_parent.store(this, std::memory_order_release);
+        m_subRegions.add(region);
+        adjustTotalPopulation(region->computeTotalPopulation());
+        noteChange();
+    }
+    else
+    {
+        RegionDeleter()(region);
+    }
+    return added;
+}
+
+bool Region::addSubregion(RegionPtr region)
+{
+    return addSubregion(region.release());
+}
+
+// Unlinks the immediate sub-region with the given id, takes its population out of the totals up the ancestor chain,
+// and deletes it along with all of its sub-regions.  The sub-region and its sub-regions can't be found by id once
+// this returns, but readers that were already looking at them can go on doing so, so they are retired rather than
+// deleted right away.
+//
+// Return true if the sub-region was found and removed, otherwise false.
+bool Region::removeSubregion(unsigned int id)
+{
+    Region* region = unlinkSubregion(id);
+    RegionDeleter()(region);
+    return region != nullptr;
+}
+
+// Unlinks the immediate sub-region with the given id and takes its population out of the totals up the ancestor
+// chain, but leaves it and its sub-regions intact, so they can be added somewhere else.  The handle can outlive the
+// world, so regions that were loaded into the world's arena are copied to the heap first, which costs a walk over the
+// sub-region's subtree.  Moving regions within a world with moveTo, or between worlds with World::mergeWorld, copies
+// nothing.
+//
+// Return the sub-region, or an empty handle if this region has no sub-region with the id.
+RegionPtr Region::detachSubregion(unsigned int id)
+{
+    Region* region = unlinkSubregion(id);
+    if (region != nullptr && region->hasArenaRegions())
+        region = region->copyToHeap();
+    return RegionPtr(region);
+}
+
+// Return the immediate sub-region with the given id, after taking it out of the list of sub-regions and its
+// population out of the totals up the ancestor chain, or nullptr if there is no such sub-region
+Region* Region::unlinkSubregion(unsigned int id)
+{
+    Region* region = getSubRegionById(id);
+    if (region == nullptr || !m_subRegions.remove(region))
+        return nullptr;
+
+    adjustTotalPopulation(-(long long) region->computeTotalPopulation());
+    region->m_parent.store(nullptr, std::memory_order_release);
+    noteChange();
+    return region;
+}
+
+// Moves all of the source's sub-regions, along with theirs, to the end of this region's sub-regions.  Only the
+// pointers move, and the totals up both ancestor chains are adjusted once for the whole merge.  Regions that come from
+// another hierarchy's arena are copied to the heap, as with detachSubregion, since they would otherwise only live as
+// long as that hierarchy's world.
+//
+// Return false, without moving anything, if this region is the source or one of its descendants, since the
+// hierarchy would then contain itself, or if it can't contain one of the source's sub-regions.
+bool Region::mergeSubregions(Region& source)
+{
+    return mergeSubregions(source, getRoot() != source.getRoot());
+}
+
+bool Region::mergeSubregions(Region& source, bool copyArenaRegions)
+{
+    for (Region* ancestor = this; ancestor != nullptr; ancestor = ancestor->getParent())
+    {
+        if (ancestor == &source)
+            return false;
+    }
+
+    std::vector<Region*> moved;
+    moved.reserve(source.m_subRegions.size());
+    for (Region* region : source.m_subRegions)
+    {
+        if (!canContain(getType(), region->getType()))
+            return false;
+        moved.push_back(region);
     }
-    holder[subCount-1]=region;
-    for(int i=0;i<subCount;i++){
-        m_subregion[i]=holder[i];
+
+    long long movedPopulation = 0;
+    for (Region* region : moved)
+    {
+        source.m_subRegions.remove(region);
+        if (copyArenaRegions && region->hasArenaRegions())
+        {
+            region->m_parent.store(nullptr, std::memory_order_release);
+            region = region->copyToHeap();
+        }
+        region->m_parent.store(this, std::memory_order_release);
+        m_subRegions.add(region);
+        movedPopulation += region->computeTotalPopulation();
+    }
+    source.adjustTotalPopulation(-movedPopulation);
+    adjustTotalPopulation(movedPopulation);
+    noteChange();
+    return true;
+}
+
+// Moves this region, along with all of its sub-regions, to the end of another region's sub-regions in the same
+// hierarchy.  Only the two lists of sub-regions change, so this is O(1) plus the cost of adjusting the totals up the
+// two ancestor chains.
+//
+// Return false, without moving anything, if this region has no parent, or the new parent can't contain this type of
+// region, is this region or one of its descendants, or is in another hierarchy.  If failure is provided, it is set to
+// which one it was, or to NoMoveFailure.
+bool Region::moveTo(Region& newParent, MoveFailure* failure)
+{
+    MoveFailure reason = NoMoveFailure;
+    Region* parent = getParent();
+    if (parent == nullptr)
+        reason = MoveFromTop;
+    else if (!canContain(newParent.getType(), getType()))
+        reason = MoveToWrongType;
+    else
+    {
+        // Walking up from the new parent finds this region, if the new parent is below it, or else the root
+        const Region* newRoot = &newParent;
+        for (const Region* ancestor = &newParent; ancestor != nullptr && reason == NoMoveFailure;
+             ancestor = ancestor->getParent())
+        {
+            if (ancestor == this)
+                reason = MoveUnderItself;
+            newRoot = ancestor;
+        }
+        if (reason == NoMoveFailure && parent->getRoot() != newRoot)
+            reason = MoveToOtherHierarchy;
     }
 
+    if (failure != nullptr)
+        *failure = reason;
+    if (reason != NoMoveFailure)
+        return false;
 
+    if (parent != &newParent)
+    {
+        long long population = computeTotalPopulation();
+        parent->m_subRegions.remove(this);
+        parent->adjustTotalPopulation(-population);
+        m_parent.store(&newParent, std::memory_order_release);
+        newParent.m_subRegions.add(this);
+        newParent.adjustTotalPopulation(population);
+        noteChange();
+    }
+    return true;
+}
+
+// Applies a change in population to the cached totals of this region and all of its ancestors.  Only the writer
+// changes totals, so a load and a store are enough.
+void Region::adjustTotalPopulation(long long delta)
+{
+    for (Region* region = this; region != nullptr; region = region->getParent())
+    {
+        unsigned int total = region->m_totalPopulation.load(std::memory_order_relaxed);
+        region->m_totalPopulation.store((unsigned int) (total + delta), std::memory_order_relaxed);
+    }
 }
 int Region::getSubRegionCount(){
-    return subCount;
+    return m_subRegions.size();
 }
 
 Region* Region::getSubRegionByIndex(int in){
-    for(int i=0;i<subCount;i++){
-        if (in == m_subregion[i]->getId())return m_subregion[i];
+    Region* result = nullptr;
+    if (in >= 0)
+        result = m_subRegions.at((unsigned int) in);
+    return result;
+}
+
+// Looks up an immediate sub-region by its id, in constant time, through the id registry
+Region* Region::getSubRegionById(unsigned int id){
+    Region* result = findById(id);
+    if (result != nullptr && result->getParent() != this)
+        result = nullptr;
+    return result;
+}
+
+// Looks up a region anywhere below this one by its id.  The registry finds the region in constant time, and then its
+// ancestry is checked, which costs O(depth) of the hierarchy.
+Region* Region::findDescendantById(unsigned int id){
+    Region* result = findById(id);
+    if (result != nullptr)
+    {
+        Region* ancestor = result->getParent();
+        while (ancestor != nullptr && ancestor != this)
+            ancestor = ancestor->getParent();
+        if (ancestor == nullptr)
+            result = nullptr;
+    }
+    return result;
+}
+
+// Looks up any live region by its id
+Region* Region::findById(unsigned int id)
+{
+    INSTRUMENT_COUNT(IdLookups);
+    Region* result = nullptr;
+    const RegistryTable* table = m_registry.load(std::memory_order_acquire);
+    if (table != nullptr && id < table->size)
+        result = table->slots[id].load(std::memory_order_acquire);
+    if (result == nullptr)
+        INSTRUMENT_COUNT(IdLookupMisses);
+    return result;
+}
+
+// Unregisters the region's subtree right away, so no reader can find it by id, and retires it
+void RegionDeleter::operator()(Region* region) const
+{
+    if (region != nullptr)
+    {
+        region->unregisterSubtree();
+        RegionEpoch::retire(region);
+    }
+}
+
+// Return true if an id read from a file, which may be corrupt, is close enough to the ids in use, or to the number of
+// regions being read, to be given a slot in the registry.  The registry has a slot for every id up to the highest, so
+// one bad id near UINT32_MAX would otherwise take gigabytes.
+bool Region::isPlausibleId(std::size_t id, std::size_t regionCount)
+{
+    return id < 2 * std::max((std::size_t) m_nextId, regionCount) + ID_HEADROOM;
+}
+
+// Return a count that goes up whenever a region is renamed, or is added to, removed from, or moved within a
+// hierarchy, so that something built from names and shape, like a RegionNameIndex, can tell when to rebuild
+std::uint64_t Region::getChangeCount()
+{
+    return m_changeCount.load(std::memory_order_acquire);
+}
+
+void Region::noteChange()
+{
+    m_changeCount.fetch_add(1, std::memory_order_release);
+}
+
+// Return one more than the highest id the registry has room for
+std::size_t Region::getRegistrySize()
+{
+    const RegistryTable* table = m_registry.load(std::memory_order_acquire);
+    return (table != nullptr) ? table->size : 0;
+}
+
+// Makes room in the registry for ids below the size.  A bigger registry is a new table, published in one store, so
+// readers can go on using the old one until they are done with it.
+void Region::reserveRegistry(std::size_t size)
+{
+    RegistryTable* table = m_registry.load(std::memory_order_relaxed);
+    std::size_t oldSize = (table != nullptr) ? table->size : 0;
+    if (size > oldSize)
+    {
+        RegistryTable* grown = new RegistryTable(std::max(size, 2 * oldSize));
+        for (std::size_t i=0; i<oldSize; i++)
+            grown->slots[i].store(table->slots[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        m_registry.store(grown, std::memory_order_release);
+        RegionEpoch::retire(table);
     }
-    std::cout<<"subRegion not found"<<std::endl;
-}
\ No newline at end of file
+}
+
+void Region::registerRegion()
+{
+    reserveRegistry((std::size_t) m_id + 1);
+    m_registry.load(std::memory_order_relaxed)->slots[m_id].store(this, std::memory_order_release);
+}
+
+void Region::unregisterRegion()
+{
+    RegistryTable* table = m_registry.load(std::memory_order_relaxed);
+    if (table != nullptr && m_id < table->size && table->slots[m_id].load(std::memory_order_relaxed) == this)
+        table->slots[m_id].store(nullptr, std::memory_order_release);
+}
+
+void Region::unregisterSubtree()
+{
+    unregisterRegion();
+    for (Region* subRegion : m_subRegions)
+        subRegion->unregisterSubtree();
+}
@@ -5,64 +5,205 @@
 #ifndef GEO_REGIONS_REGION_H
 #define GEO_REGIONS_REGION_H
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
+
+#include "SubRegionList.h"
+
+class BufferedWriter;
+class RegionArena;
+class RegionRollup;
+class Region;
+
+// Disposes of a region owned by a RegionPtr, along with its sub-regions.  They can't be found by id once the handle
+// lets go of them, and they are deleted once no reader can still be looking at them (see RegionEpoch).
+struct RegionDeleter {
+    void operator()(Region* region) const;
+};
+
+// Sole owner of a region that isn't in a hierarchy, e.g., one that was just created or was detached from its parent.
+// Handing it to addSubregion moves the whole subtree without copying anything, and letting it go deletes the subtree.
+typedef std::unique_ptr<Region, RegionDeleter> RegionPtr;
 
 class Region {
+    friend struct RegionDeleter;
+    friend class RegionSnapshot;
+    friend class ParallelRegionLoader;
+    friend class RegionRollup;
+    friend class RegionNameIndex;
+    friend class RegionColumns;
+    friend class RegionJournal;
+    friend class SubRegionList;
+    template <typename Derived> friend class RegionVisitor;
+
 public:
     typedef enum RegionType { UnknownRegionType, WorldType, NationType, StateType, CountyType, CityType } x;
 
+    static constexpr std::string_view regionDelimiter = "^^^";     // ends a region's list of sub-regions in a data file
+    static constexpr unsigned int REGION_TYPE_COUNT = CityType + 1;
+
+    // Why moveTo didn't move a region
+    enum MoveFailure { NoMoveFailure, MoveFromTop, MoveToWrongType, MoveUnderItself, MoveToOtherHierarchy };
+
+private:
+    // The shape of the hierarchy: for each type of region, a bit for each type of region it can contain
+    static constexpr unsigned int subRegionTypes[REGION_TYPE_COUNT] = {
+            0,                                              // UnknownRegionType
+            1u << NationType,                               // WorldType
+            1u << StateType,                                // NationType
+            (1u << CountyType) | (1u << CityType),          // StateType
+            1u << CityType,                                 // CountyType
+            0                                               // CityType
+    };
+    static constexpr std::string_view regionLabels[REGION_TYPE_COUNT] = {
+            "Unknown", "World", "Nation", "State", "County", "City"
+    };
+
+public:
+    // Return true if a region of the parent type can have sub-regions of the other type.  Types read from a file can
+    // be anything, so both are range-checked; the lookup itself is a shift and a mask.
+    static constexpr bool canContain(RegionType parentType, RegionType subRegionType)
+    {
+        return (unsigned int) parentType < REGION_TYPE_COUNT && (unsigned int) subRegionType < REGION_TYPE_COUNT &&
+               ((subRegionTypes[parentType] >> subRegionType) & 1u) != 0;
+    }
+
+    // Return the label for a type of region, from a table rather than a switch, so reports can write it per region
+    static constexpr std::string_view regionLabelView(RegionType regionType)
+    {
+        return regionLabels[(unsigned int) regionType < REGION_TYPE_COUNT ? regionType : UnknownRegionType];
+    }
+
+    // The same rule for two subclasses, e.g., canContain<State, City>(), which is settled at compile time
+    template <typename Parent, typename SubRegion>
+    static constexpr bool canContain() { return canContain(Parent::regionType, SubRegion::regionType); }
+
+// Everything that can change after a region is created can be read while one writer changes it, as described in
+// RegionEpoch: the numbers are atomics, and a new name, list of sub-regions, or registry is published in one store
+// while the old one is retired.  A removed region is taken out of its parent and the registry right away, but it is
+// only deleted once no reader can still be looking at it.
 protected:
-    unsigned int    m_id = 0;
-    RegionType      m_regionType = UnknownRegionType;
-    std::string     m_name;
-    unsigned int    m_population = 0;
-    double          m_area = 0;
-    bool            m_isValid = false;
-    Region* m_subregion[500];
-    int subCount=0;
-    // DONE: Add data members to manage sub-regions
+    unsigned int                    m_id = 0;
+    RegionType                      m_regionType = UnknownRegionType;
+    std::string                     m_createdName;
+    std::atomic<const std::string*> m_name{&m_createdName};     // m_createdName until the region is renamed
+    std::atomic<unsigned int>       m_population{0};
+    std::atomic<unsigned int>       m_totalPopulation{0};       // m_population plus all sub-regions', kept up to date
+    std::atomic<double>             m_area{0};
+    bool                            m_isValid = false;
+    std::atomic<Region*>            m_parent{nullptr};
+    unsigned int                    m_indexInParent = 0;        // slot in the parent's m_subRegions, kept by the list
+    SubRegionList                   m_subRegions;
 
 private:
+    struct RegistryTable;
+
+    static const std::size_t ALLOCATION_HEADER_SIZE = alignof(std::max_align_t);
+    static const char HEAP_ALLOCATED = 'H';
+    static const char ARENA_ALLOCATED = 'A';
+    static const std::size_t ID_HEADROOM = 1 << 16;     // how far an id read from a file may be past the ids in use
+
     static unsigned int m_nextId;
+    static std::atomic<RegistryTable*> m_registry;  // indexed by id, so every live region can be found in O(1)
+    static std::atomic<std::uint64_t> m_changeCount;    // see getChangeCount
+    static thread_local bool m_useReservedIds;  // set while a thread hands out ids from a range reserved for it
+    static thread_local unsigned int m_nextReservedId;
 
 public:
+    static Region* load(const std::string& filename, bool* fileFound = nullptr, bool useArena = false,
+                        unsigned int threadCount = 1);
     static Region* create(std::istream &in);
-    static Region* create(const std::string& data);
-    static Region* create(RegionType regionType, const std::string& data);
+    static Region* create(std::string_view data, RegionArena* arena = nullptr);
+    static Region* create(RegionType regionType, std::string_view data, RegionArena* arena = nullptr);
+    static Region* create(RegionType regionType, std::string_view name, unsigned int population, double area,
+                          RegionArena* arena = nullptr);
+    static Region* loadSnapshot(const std::string& filename, bool* fileFound = nullptr, bool useArena = false,
+                                std::uint32_t* generation = nullptr);
     static std::string regionLabel(RegionType regionType);
+    static Region* findById(unsigned int id);
+    static std::uint64_t getChangeCount();
 
 protected:
     Region();
-    Region(RegionType type, const std::string data[]);
+    Region(RegionType type, const std::string_view data[]);
+    Region(RegionType type, std::string_view name, unsigned int population, double area);
 
 public:
-    ~Region();
+    virtual ~Region();
+    static void* operator new(std::size_t size);
+    static void* operator new(std::size_t size, RegionArena* arena);
+    static void operator delete(void* region);
+    static void operator delete(void* region, RegionArena* arena);
+
     unsigned int getId() const { return m_id; }
     RegionType  getType() const { return m_regionType; }
     std::string getRegionLabel() const;
-    const std::string& getName() const { return m_name; }
-    void setName(const std::string& name) { m_name = name; }
-    unsigned int getPopulation() const { return m_population; }
-    void setPopulation(unsigned int population) { m_population = population; }
-    double getArea() const { return m_area; }
-    void setArea(double area) { m_area = area; }
+    const std::string& getName() const { return *m_name.load(std::memory_order_acquire); }
+    void setName(const std::string& name);
+    unsigned int getPopulation() const { return m_population.load(std::memory_order_relaxed); }
+    void setPopulation(unsigned int population);
+    double getArea() const { return m_area.load(std::memory_order_relaxed); }
+    void setArea(double area) { m_area.store(area, std::memory_order_relaxed); }
     bool getIsValid() const { return m_isValid; }
+    Region* getParent() const { return m_parent.load(std::memory_order_acquire); }
     int getSubRegionCount();
 
     // DONE: Add methods to manage sub-regions
-    void addSubregion(Region* region);//k
+    bool addSubregion(Region* region);//k
+    bool addSubregion(RegionPtr region);
     Region* getSubRegionByIndex(int in);
+    Region* getSubRegionById(unsigned int id);
+    Region* findDescendantById(unsigned int id);
+    bool removeSubregion(unsigned int id);
+    RegionPtr detachSubregion(unsigned int id);
+    bool mergeSubregions(Region& source);
+    bool moveTo(Region& newParent, MoveFailure* failure = nullptr);
+    std::string describeMoveFailure(MoveFailure failure, const Region& newParent) const;
     // DONE: Add method to compute total population, as m_population + the total population for all sub-regions
     unsigned int computeTotalPopulation();
 
     void list(std::ostream& out);
     void display(std::ostream& out, unsigned int displayLevel, bool showChild);
+    void display(std::ostream& out, unsigned int displayLevel, bool showChild, const RegionRollup& rollup);
     void save(std::ostream& out);
+    bool save(const std::string& filename, bool syncToDisk = false, std::string* error = nullptr);
+    bool saveSnapshot(const std::string& filename, std::uint32_t generation = 0);
 
 protected:
-    virtual void validate();
+    void validate();
     void loadChildren(std::istream& in);
+    static Region* parse(std::string_view& text, bool useArena);
+    void parseChildren(std::string_view& text, RegionArena* arena);
+    bool isMisplaced(std::string_view line) const;
+    static void skipSubtree(std::istream& in);
+    static void skipSubtree(std::string_view& text);
+    void deleteSubRegions();
+    void save(BufferedWriter& writer);
     static unsigned int getNextId();
+    bool mergeSubregions(Region& source, bool copyArenaRegions);
+
+private:
+    static Region* createWithId(unsigned int id, RegionType regionType, std::string_view name,
+                                unsigned int population, double area, RegionArena* arena = nullptr,
+                                std::size_t regionCount = 0);
+    static bool isPlausibleId(std::size_t id, std::size_t regionCount = 0);
+    static std::size_t getRegistrySize();
+    static void reserveRegistry(std::size_t size);
+    void registerRegion();
+    void unregisterRegion();
+    void unregisterSubtree();
+    void adjustTotalPopulation(long long delta);
+    static void noteChange();
+    Region* unlinkSubregion(unsigned int id);
+    bool hasArenaRegions() const;
+    Region* copyToHeap();
+    Region* copySubtree() const;
+    const Region* getRoot() const;
 
     // TODO: add whatever other helper methods you might need
 };
@@ -0,0 +1,41 @@
+//
+// Bump allocator that holds the regions of a bulk-loaded world.
+//
+
+#include "RegionArena.h"
+
+#include <new>
+
+RegionArena::RegionArena(std::size_t blockSize) : m_blockSize(blockSize > 0 ? blockSize : DEFAULT_BLOCK_SIZE)
+{
+}
+
+RegionArena::~RegionArena()
+{
+    for (char* block : m_blocks)
+        ::operator delete(block);
+}
+
+// Return memory for an object of the given size, aligned for any type
+void* RegionArena::allocate(std::size_t size)
+{
+    size = (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    if ((std::size_t) (m_end - m_next) < size)
+        addBlock(size);
+
+    void* result = m_next;
+    m_next += size;
+    m_bytesAllocated += size;
+    return result;
+}
+
+// Starts a new block that can hold at least minimumSize bytes.  Whatever was left at the end of the previous block is
+// simply not used.
+void RegionArena::addBlock(std::size_t minimumSize)
+{
+    std::size_t size = (minimumSize > m_blockSize) ? minimumSize : m_blockSize;
+    char* block = (char*) ::operator new(size);
+    m_blocks.push_back(block);
+    m_next = block;
+    m_end = block + size;
+}
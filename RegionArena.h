@@ -0,0 +1,43 @@
+//
+// Bump allocator that holds the regions of a bulk-loaded world.
+//
+
+#ifndef GEO_REGIONS_REGION_ARENA_H
+#define GEO_REGIONS_REGION_ARENA_H
+
+#include <cstddef>
+#include <vector>
+
+// Hands out memory from a few large blocks, one after another, so that regions loaded together sit next to each other
+// in memory in the order they were loaded.  A loader goes in pre-order, so each region is followed by its whole
+// subtree: a parent is next to its first sub-region, but the next sibling only comes after that sub-region's subtree.
+// Nothing is given back until the arena itself is destroyed, at which point all of the blocks are released at once.
+// An arena is not thread-safe.
+class RegionArena {
+public:
+    static const std::size_t DEFAULT_BLOCK_SIZE = 1 << 20;
+    static const std::size_t ALIGNMENT = alignof(std::max_align_t);
+
+private:
+    std::vector<char*>  m_blocks;
+    char*               m_next = nullptr;
+    char*               m_end = nullptr;
+    std::size_t         m_blockSize;
+    std::size_t         m_bytesAllocated = 0;
+
+public:
+    explicit RegionArena(std::size_t blockSize = DEFAULT_BLOCK_SIZE);
+    ~RegionArena();
+    RegionArena(const RegionArena&) = delete;
+    RegionArena& operator=(const RegionArena&) = delete;
+
+    void* allocate(std::size_t size);
+
+    std::size_t getBlockCount() const { return m_blocks.size(); }
+    std::size_t getBytesAllocated() const { return m_bytesAllocated; }
+
+private:
+    void addBlock(std::size_t minimumSize);
+};
+
+#endif //GEO_REGIONS_REGION_ARENA_H
@@ -0,0 +1,152 @@
+//
+// Column-oriented copy of a region hierarchy for scans over many regions.
+//
+
+#include "RegionColumns.h"
+#include "RegionVisitor.h"
+
+// Adds a row for each region, and fills in its subtree end once the rows for its sub-regions are in
+struct RegionColumns::RowBuilder : RegionVisitor<RowBuilder> {
+    RegionColumns&              columns;
+    std::vector<std::uint32_t>  rows;       // the rows of the regions whose sub-regions are being added
+
+    explicit RowBuilder(RegionColumns& columns) : columns(columns) {}
+
+    bool enter(const Region& region, unsigned int)
+    {
+        rows.push_back(columns.addRow(region, rows.empty() ? NO_PARENT : rows.back()));
+        return true;
+    }
+
+    void leave(const Region&, unsigned int)
+    {
+        columns.m_subtreeEnds[rows.back()] = (std::uint32_t) columns.m_ids.size();
+        rows.pop_back();
+    }
+};
+
+RegionColumns::RegionColumns(const Region& root)
+{
+    RowBuilder(*this).visit(root);
+    m_nameOffsets.push_back((std::uint32_t) m_names.size());
+}
+
+std::string_view RegionColumns::getName(std::size_t row) const
+{
+    return std::string_view(m_names).substr(m_nameOffsets[row], m_nameOffsets[row+1] - m_nameOffsets[row]);
+}
+
+// Return the sum of the populations of all regions of the type, or of all regions if the type is unknown.  Each
+// region's own population is counted, so this is the total for the whole hierarchy no matter what type it is.
+unsigned long long RegionColumns::sumPopulation(Region::RegionType regionType) const
+{
+    const std::size_t rowCount = size();
+    const std::uint32_t* populations = m_populations.data();
+    const std::uint8_t* types = m_types.data();
+    unsigned long long sum = 0;
+
+    if (regionType == Region::UnknownRegionType)
+    {
+        for (std::size_t i=0; i<rowCount; i++)
+            sum += populations[i];
+    }
+    else
+    {
+        const std::uint8_t wantedType = (std::uint8_t) regionType;
+        for (std::size_t i=0; i<rowCount; i++)
+            sum += (types[i] == wantedType) ? populations[i] : 0;
+    }
+    return sum;
+}
+
+// Return the rows of the regions of the type whose own population per unit of area is more than density.  Regions
+// without an area are never included.
+//
+// The comparison is done as population > density * area, without a division, in a first pass that only fills in a
+// byte per row, so that it vectorizes.  The matching rows are gathered in a second pass.
+std::vector<std::uint32_t> RegionColumns::findDenserThan(Region::RegionType regionType, double density) const
+{
+    const std::size_t rowCount = size();
+    const std::uint32_t* populations = m_populations.data();
+    const double* areas = m_areas.data();
+    const std::uint8_t* types = m_types.data();
+    const std::uint8_t wantedType = (std::uint8_t) regionType;
+
+    std::vector<std::uint8_t> matches(rowCount);
+    std::uint8_t* isMatch = matches.data();
+    for (std::size_t i=0; i<rowCount; i++)
+        isMatch[i] = (std::uint8_t) ((types[i] == wantedType) & (areas[i] > 0) &
+                                     ((double) populations[i] > density * areas[i]));
+
+    std::vector<std::uint32_t> rows;
+    for (std::size_t i=0; i<rowCount; i++)
+    {
+        if (isMatch[i])
+            rows.push_back((std::uint32_t) i);
+    }
+    return rows;
+}
+
+// Return the total population of every row's subtree.  Since every row comes after its parent, one pass from the
+// last row to the first adds each subtree into its parent after the subtree itself is complete.
+std::vector<unsigned long long> RegionColumns::computeTotalPopulations() const
+{
+    const std::size_t rowCount = size();
+    std::vector<unsigned long long> totals(m_populations.begin(), m_populations.end());
+    for (std::size_t i=rowCount; i>1; i--)
+        totals[m_parents[i-1]] += totals[i-1];
+    return totals;
+}
+
+// Return each row's own population per unit of area, or 0 for rows without an area
+std::vector<double> RegionColumns::computeDensities() const
+{
+    std::vector<double> densities(size());
+    ColumnKernels::computeDensities(m_populations.data(), m_areas.data(), densities.data(), size());
+    return densities;
+}
+
+RowBitmap RegionColumns::selectPopulation(std::uint32_t min, std::uint32_t max) const
+{
+    return ColumnKernels::selectRange(m_populations.data(), size(), min, max);
+}
+
+RowBitmap RegionColumns::selectArea(double min, double max) const
+{
+    return ColumnKernels::selectRange(m_areas.data(), size(), min, max);
+}
+
+RowBitmap RegionColumns::selectDensity(double min, double max) const
+{
+    return selectDensity(computeDensities(), min, max);
+}
+
+// Selects from densities that were already computed, so that several queries can share them
+RowBitmap RegionColumns::selectDensity(const std::vector<double>& densities, double min, double max)
+{
+    return ColumnKernels::selectRange(densities.data(), densities.size(), min, max);
+}
+
+// Return the region ids of the rows whose bits are set
+std::vector<std::uint32_t> RegionColumns::getIds(const RowBitmap& rows) const
+{
+    std::vector<std::uint32_t> ids = ColumnKernels::getRows(rows);
+    for (std::uint32_t& id : ids)
+        id = m_ids[id];
+    return ids;
+}
+
+// Return the new row
+std::uint32_t RegionColumns::addRow(const Region& region, std::uint32_t parentRow)
+{
+    std::uint32_t row = (std::uint32_t) m_ids.size();
+    m_ids.push_back(region.getId());
+    m_types.push_back((std::uint8_t) region.getType());
+    m_parents.push_back(parentRow);
+    m_subtreeEnds.push_back(0);
+    m_populations.push_back(region.getPopulation());
+    m_areas.push_back(region.getArea());
+    m_nameOffsets.push_back((std::uint32_t) m_names.size());
+    m_names += region.getName();
+    return row;
+}
@@ -0,0 +1,67 @@
+//
+// Column-oriented copy of a region hierarchy for scans over many regions.
+//
+
+#ifndef GEO_REGIONS_REGION_COLUMNS_H
+#define GEO_REGIONS_REGION_COLUMNS_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ColumnKernels.h"
+#include "Region.h"
+
+// Holds the fields of every region in a hierarchy in parallel arrays, one row per region, in the same pre-order as a
+// data file.  A scan over one field only touches that field's array, one value after another, instead of hopping
+// from region object to region object, so the scans below compile to tight loops the compiler can vectorize.
+//
+// Row 0 is the root.  A region's sub-regions are the rows after it, up to its subtree end, so the rows of any subtree
+// are contiguous.  Like the other derived views of a hierarchy, the columns are a copy of the hierarchy at the time
+// they were built and don't follow later changes.
+class RegionColumns {
+public:
+    static const std::uint32_t NO_PARENT = UINT32_MAX;
+
+private:
+    std::vector<std::uint32_t>  m_ids;
+    std::vector<std::uint8_t>   m_types;
+    std::vector<std::uint32_t>  m_parents;          // row of the parent, or NO_PARENT for the root
+    std::vector<std::uint32_t>  m_subtreeEnds;      // row just past the last descendant
+    std::vector<std::uint32_t>  m_populations;
+    std::vector<double>         m_areas;
+    std::vector<std::uint32_t>  m_nameOffsets;      // one more than the rows, so row i's name ends where i+1's starts
+    std::string                 m_names;
+
+public:
+    explicit RegionColumns(const Region& root);
+
+    std::size_t size() const { return m_ids.size(); }
+
+    const std::vector<std::uint32_t>& getIds() const { return m_ids; }
+    const std::vector<std::uint8_t>& getTypes() const { return m_types; }
+    const std::vector<std::uint32_t>& getParents() const { return m_parents; }
+    const std::vector<std::uint32_t>& getSubtreeEnds() const { return m_subtreeEnds; }
+    const std::vector<std::uint32_t>& getPopulations() const { return m_populations; }
+    const std::vector<double>& getAreas() const { return m_areas; }
+    std::string_view getName(std::size_t row) const;
+
+    unsigned long long sumPopulation(Region::RegionType regionType = Region::UnknownRegionType) const;
+    std::vector<std::uint32_t> findDenserThan(Region::RegionType regionType, double density) const;
+    std::vector<unsigned long long> computeTotalPopulations() const;
+
+    std::vector<double> computeDensities() const;
+    RowBitmap selectPopulation(std::uint32_t min, std::uint32_t max) const;
+    RowBitmap selectArea(double min, double max) const;
+    RowBitmap selectDensity(double min, double max) const;
+    static RowBitmap selectDensity(const std::vector<double>& densities, double min, double max);
+    std::vector<std::uint32_t> getIds(const RowBitmap& rows) const;
+
+private:
+    struct RowBuilder;
+
+    std::uint32_t addRow(const Region& region, std::uint32_t parentRow);
+};
+
+#endif //GEO_REGIONS_REGION_COLUMNS_H
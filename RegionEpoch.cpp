@@ -0,0 +1,167 @@
+//
+// Epoch-based reclamation, so readers can walk a hierarchy without locks while a writer changes it.
+//
+
+#include "RegionEpoch.h"
+
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A thread's announcement of the epoch it started reading in, or 0 while it isn't reading
+struct RegionEpoch::Reader {
+    std::atomic<std::uint64_t>  epoch{0};
+    unsigned int                depth = 0;
+};
+
+struct RegionEpoch::Retired {
+    std::uint64_t   epoch;
+    void*           object;
+    Reclaimer       reclaimer;
+};
+
+struct RegionEpoch::State {
+    std::mutex              readersMutex;
+    std::vector<Reader*>    readers;
+    std::mutex              retiredMutex;
+    std::vector<Retired>    retired;
+    std::size_t             reclaimAt = 1;  // how many retired objects it takes to look for ones to reclaim again
+};
+
+// Epochs start at 1, so that 0 can mean a thread isn't reading
+std::atomic<std::uint64_t> RegionEpoch::m_epoch(1);
+
+// Keeps a thread's reader registered for as long as the thread runs
+struct RegionEpoch::ReaderRegistration {
+    Reader  reader;
+    State&  state;
+
+    explicit ReaderRegistration(State& state) : state(state)
+    {
+        std::lock_guard<std::mutex> lock(state.readersMutex);
+        state.readers.push_back(&reader);
+    }
+
+    ~ReaderRegistration()
+    {
+        std::lock_guard<std::mutex> lock(state.readersMutex);
+        for (std::size_t i=0; i<state.readers.size(); i++)
+        {
+            if (state.readers[i] == &reader)
+            {
+                state.readers[i] = state.readers.back();
+                state.readers.pop_back();
+                break;
+            }
+        }
+    }
+};
+
+// The fence after the announcement pairs with the one in reclaim(): either the writer sees this reader's epoch, or
+// this reader sees everything the writer did before it retired anything
+RegionEpoch::ReadGuard::ReadGuard()
+{
+    Reader& reader = getReader();
+    if (reader.depth++ == 0)
+    {
+        reader.epoch.store(m_epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+}
+
+RegionEpoch::ReadGuard::~ReadGuard()
+{
+    Reader& reader = getReader();
+    if (--reader.depth == 0)
+        reader.epoch.store(0, std::memory_order_release);
+}
+
+// Hands over an object that readers may still be using, once it is no longer reachable from the hierarchy.  The
+// reclaimer is called on it once no reader can still have it, which may be right away.
+void RegionEpoch::retire(void* object, Reclaimer reclaimer)
+{
+    if (object == nullptr)
+        return;
+
+    // Readers that started in this epoch or earlier may have seen the object, but later ones can't have
+    std::uint64_t epoch = m_epoch.fetch_add(1, std::memory_order_seq_cst);
+    bool isReclaimDue;
+    {
+        State& state = getState();
+        std::lock_guard<std::mutex> lock(state.retiredMutex);
+        state.retired.push_back({ epoch, object, reclaimer });
+        isReclaimDue = (state.retired.size() >= state.reclaimAt);
+    }
+    if (isReclaimDue)
+        reclaim();
+}
+
+// Waits for the readers that might still be using retired objects to finish, and reclaims every retired object.  It
+// must not be called while the calling thread holds a ReadGuard.
+void RegionEpoch::synchronize()
+{
+    reclaim();
+    while (getRetiredCount() > 0)
+    {
+        std::this_thread::yield();
+        reclaim();
+    }
+}
+
+std::size_t RegionEpoch::getRetiredCount()
+{
+    State& state = getState();
+    std::lock_guard<std::mutex> lock(state.retiredMutex);
+    return state.retired.size();
+}
+
+RegionEpoch::Reader& RegionEpoch::getReader()
+{
+    thread_local ReaderRegistration registration(getState());
+    return registration.reader;
+}
+
+RegionEpoch::State& RegionEpoch::getState()
+{
+    static State state;
+    return state;
+}
+
+// Reclaims every retired object that was retired before the epoch the oldest active reader started in.  The next
+// retire only looks again once there are twice as many retired objects as were kept, so while a long reader holds
+// them back, each retire costs O(1) on average rather than a pass over all of them.
+void RegionEpoch::reclaim()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    State& state = getState();
+    std::uint64_t oldestEpoch = UINT64_MAX;
+    {
+        std::lock_guard<std::mutex> lock(state.readersMutex);
+        for (const Reader* reader : state.readers)
+        {
+            std::uint64_t epoch = reader->epoch.load(std::memory_order_seq_cst);
+            if (epoch != 0 && epoch < oldestEpoch)
+                oldestEpoch = epoch;
+        }
+    }
+
+    std::vector<Retired> reclaimable;
+    {
+        std::lock_guard<std::mutex> lock(state.retiredMutex);
+        std::size_t kept = 0;
+        for (const Retired& retired : state.retired)
+        {
+            if (retired.epoch < oldestEpoch)
+                reclaimable.push_back(retired);
+            else
+                state.retired[kept++] = retired;
+        }
+        state.retired.resize(kept);
+        state.reclaimAt = (kept > 0) ? 2 * kept : 1;
+    }
+
+    // Reclaimers are called without holding a lock, since reclaiming a region can retire more
+    for (const Retired& retired : reclaimable)
+        retired.reclaimer(retired.object);
+}
@@ -0,0 +1,63 @@
+//
+// Epoch-based reclamation, so readers can walk a hierarchy without locks while a writer changes it.
+//
+
+#ifndef GEO_REGIONS_REGION_EPOCH_H
+#define GEO_REGIONS_REGION_EPOCH_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Any number of reader threads can run display, list, lookups, and rollups on a hierarchy while one writer thread
+// adds, edits, and deletes regions, as long as each reader holds a ReadGuard while it reads.  Readers never lock or
+// wait.  The writer never changes anything a reader might be in the middle of reading: it builds a new copy of what
+// it is changing, e.g., a list of sub-regions or a name, publishes it with a single atomic store, and retires the old
+// copy here rather than deleting it.  Removed regions are retired the same way.
+//
+// Every guard records the global epoch when it starts, and every retired object records the epoch it was retired in.
+// A retired object is only reclaimed once every reader that might have seen it has finished, i.e., once every active
+// reader started in a later epoch.  With no readers active, objects are reclaimed as soon as they are retired, so
+// a program that doesn't use readers frees memory exactly when it did before.  Objects held back by a reader are
+// looked at again in batches, each time their number doubles, so they may outlast the reader until the next batch
+// or synchronize(), which reclaims everything.
+//
+// Readers see each value either before or after a change, never half of one, but a reader that walks the hierarchy
+// while the writer is busy may see some changes and not others.  Only one thread may write at a time.
+class RegionEpoch {
+public:
+    typedef void (*Reclaimer)(void* object);
+
+    // Marks the current thread as reading for as long as the guard exists.  Guards can be nested.
+    class ReadGuard {
+    public:
+        ReadGuard();
+        ~ReadGuard();
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+    };
+
+private:
+    struct Reader;
+    struct ReaderRegistration;
+    struct Retired;
+    struct State;
+
+    static std::atomic<std::uint64_t> m_epoch;
+
+public:
+    static void retire(void* object, Reclaimer reclaimer);
+
+    template <typename T>
+    static void retire(T* object) { retire(object, [](void* retired) { delete static_cast<T*>(retired); }); }
+
+    static void synchronize();
+    static std::size_t getRetiredCount();
+
+private:
+    static Reader& getReader();
+    static State& getState();
+    static void reclaim();
+};
+
+#endif //GEO_REGIONS_REGION_EPOCH_H
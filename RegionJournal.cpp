@@ -0,0 +1,387 @@
+//
+// Append-only journal of the changes made to a region hierarchy since its last snapshot.
+//
+
+#include "RegionJournal.h"
+#include "LittleEndian.h"
+#include "MappedFile.h"
+#include "Region.h"
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    const char journalMagic[4] = { 'G', 'E', 'O', 'J' };
+
+    void appendU32(std::string& bytes, std::uint32_t value)
+    {
+        char encoded[4];
+        LittleEndian::putU32(encoded, value);
+        bytes.append(encoded, sizeof(encoded));
+    }
+
+    void appendF64(std::string& bytes, double value)
+    {
+        char encoded[8];
+        LittleEndian::putF64(encoded, value);
+        bytes.append(encoded, sizeof(encoded));
+    }
+}
+
+// The journal isn't touched until open() is called
+RegionJournal::RegionJournal(const std::string& filename, const std::string& snapshotFile, bool syncToDisk,
+                             std::size_t compactionSize) :
+        m_filename(filename), m_snapshotFile(snapshotFile), m_syncToDisk(syncToDisk), m_compactionSize(compactionSize)
+{
+}
+
+RegionJournal::~RegionJournal()
+{
+    close();
+}
+
+// Starts journaling the changes to a hierarchy that was just loaded from the snapshot with the given generation.  If
+// replay is true and the journal on disk belongs to that snapshot, its changes are applied to the hierarchy first and
+// new changes are appended after them, otherwise the journal starts over.
+//
+// Return the number of changes that were replayed.  Check isOpen() to see whether the journal is ready for more.
+std::size_t RegionJournal::open(Region& root, std::uint32_t generation, bool replay)
+{
+    close();
+    m_root = &root;
+    m_generation = generation;
+    m_error.clear();
+
+    std::size_t replayed = 0;
+    bool isMatch = false;
+    if (replay)
+    {
+        MappedFile file(m_filename);
+        std::string_view journal = file.getText();
+        isMatch = (file.isOpen() && journal.size() >= HEADER_SIZE &&
+                   std::memcmp(journal.data(), journalMagic, sizeof(journalMagic)) == 0 &&
+                   LittleEndian::getU32(journal.data() + 4) == VERSION &&
+                   LittleEndian::getU32(journal.data() + 8) == generation);
+        if (isMatch)
+            replayed = replayRecords(journal);
+    }
+
+    if (isMatch)
+        openForAppend(m_size);
+    else
+        start(generation);
+    return replayed;
+}
+
+// Writes the whole hierarchy to a new snapshot and starts a new, empty journal for it
+//
+// Return true if both worked, otherwise false with the reason in getError().
+bool RegionJournal::compact()
+{
+    bool compacted = false;
+    if (m_root == nullptr)
+        fail("The journal has not been opened");
+    else if (!m_root->saveSnapshot(m_snapshotFile, m_generation + 1))
+        fail("Could not write " + m_snapshotFile);
+    else
+        compacted = start(m_generation + 1);
+    return compacted;
+}
+
+bool RegionJournal::isOpen() const
+{
+#ifdef _WIN32
+    return m_fileStream.is_open();
+#else
+    return m_fd >= 0;
+#endif
+}
+
+// Records that a region was added to its parent, along with everything needed to create it again
+bool RegionJournal::recordAdd(const Region& region)
+{
+    std::string payload(1, (char) AddOperation);
+    appendU32(payload, region.getId());
+    appendU32(payload, region.getParent() != nullptr ? region.getParent()->getId() : UINT32_MAX);
+    appendU32(payload, (std::uint32_t) region.getType());
+    appendU32(payload, region.getPopulation());
+    appendF64(payload, region.getArea());
+    payload += region.getName();
+    return append(payload);
+}
+
+bool RegionJournal::recordName(const Region& region)
+{
+    std::string payload(1, (char) NameOperation);
+    appendU32(payload, region.getId());
+    payload += region.getName();
+    return append(payload);
+}
+
+bool RegionJournal::recordPopulation(const Region& region)
+{
+    std::string payload(1, (char) PopulationOperation);
+    appendU32(payload, region.getId());
+    appendU32(payload, region.getPopulation());
+    return append(payload);
+}
+
+bool RegionJournal::recordArea(const Region& region)
+{
+    std::string payload(1, (char) AreaOperation);
+    appendU32(payload, region.getId());
+    appendF64(payload, region.getArea());
+    return append(payload);
+}
+
+// Records that the sub-region with the id was removed from the parent, along with all of its sub-regions
+bool RegionJournal::recordRemove(const Region& parent, unsigned int id)
+{
+    std::string payload(1, (char) RemoveOperation);
+    appendU32(payload, parent.getId());
+    appendU32(payload, id);
+    return append(payload);
+}
+
+// Records that a region was moved, along with all of its sub-regions, to the end of its parent's sub-regions
+bool RegionJournal::recordMove(const Region& region)
+{
+    std::string payload(1, (char) MoveOperation);
+    appendU32(payload, region.getId());
+    appendU32(payload, region.getParent() != nullptr ? region.getParent()->getId() : UINT32_MAX);
+    return append(payload);
+}
+
+// Applies the records after the header, up to the first one that is incomplete or damaged, and sets the size of the
+// journal to the end of the last good record.  A complete record that can't be applied, e.g., because it refers to a
+// region that isn't there, is skipped.
+//
+// Return the number of records applied.
+std::size_t RegionJournal::replayRecords(std::string_view journal)
+{
+    std::size_t applied = 0;
+    std::size_t offset = HEADER_SIZE;
+    bool isValid = true;
+    while (isValid && journal.size() - offset >= RECORD_HEADER_SIZE)
+    {
+        std::uint32_t length = LittleEndian::getU32(journal.data() + offset);
+        std::uint32_t expectedChecksum = LittleEndian::getU32(journal.data() + offset + 4);
+        isValid = (length > 0 && length <= journal.size() - offset - RECORD_HEADER_SIZE);
+
+        std::string_view payload;
+        if (isValid)
+        {
+            payload = journal.substr(offset + RECORD_HEADER_SIZE, length);
+            isValid = (checksum(payload) == expectedChecksum);
+        }
+
+        if (isValid)
+        {
+            if (apply(payload))
+                applied++;
+            offset += RECORD_HEADER_SIZE + length;
+        }
+    }
+
+    m_size = offset;
+    return applied;
+}
+
+// Return true if the change in the payload could be applied to the hierarchy
+bool RegionJournal::apply(std::string_view payload)
+{
+    const char* bytes = payload.data();
+    bool applied = false;
+    Region* region = (payload.size() >= 5) ? Region::findById(LittleEndian::getU32(bytes + 1)) : nullptr;
+    switch ((Operation) payload[0])
+    {
+        case AddOperation:
+            if (payload.size() >= 25)
+            {
+                unsigned int id = LittleEndian::getU32(bytes + 1);
+                Region* parent = Region::findById(LittleEndian::getU32(bytes + 5));
+                Region::RegionType regionType = (Region::RegionType) LittleEndian::getU32(bytes + 9);
+                Region* added = nullptr;
+                if (isInHierarchy(parent) && Region::canContain(parent->getType(), regionType))
+                    added = Region::createWithId(id, regionType, payload.substr(25), LittleEndian::getU32(bytes + 13),
+                                                 LittleEndian::getF64(bytes + 17));
+
+                // Later records refer to the region by its id, so it is only of use if it got its old id back
+                applied = (added != nullptr && added->getId() == id);
+                if (applied)
+                    parent->addSubregion(added);
+                else
+                    delete added;
+            }
+            break;
+        case NameOperation:
+            applied = isInHierarchy(region);
+            if (applied)
+                region->setName(std::string(payload.substr(5)));
+            break;
+        case PopulationOperation:
+            applied = (payload.size() == 9 && isInHierarchy(region));
+            if (applied)
+                region->setPopulation(LittleEndian::getU32(bytes + 5));
+            break;
+        case AreaOperation:
+            applied = (payload.size() == 13 && isInHierarchy(region));
+            if (applied)
+                region->setArea(LittleEndian::getF64(bytes + 5));
+            break;
+        case RemoveOperation:
+            applied = (payload.size() == 9 && isInHierarchy(region) &&
+                       region->removeSubregion(LittleEndian::getU32(bytes + 5)));
+            break;
+        case MoveOperation:
+            if (payload.size() == 9 && isInHierarchy(region))
+            {
+                Region* newParent = Region::findById(LittleEndian::getU32(bytes + 5));
+                applied = (isInHierarchy(newParent) && region->moveTo(*newParent));
+            }
+            break;
+        default:
+            break;
+    }
+    return applied;
+}
+
+// Replaces the journal with an empty one for the given generation
+bool RegionJournal::start(std::uint32_t generation)
+{
+    close();
+    m_generation = generation;
+    m_size = 0;
+
+#ifdef _WIN32
+    m_fileStream.open(m_filename, std::ios::binary | std::ios::trunc);
+#else
+    m_fd = ::open(m_filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+#endif
+    if (!isOpen())
+        return fail("Could not open " + m_filename + ": " + std::strerror(errno));
+
+    char header[HEADER_SIZE];
+    std::memcpy(header, journalMagic, sizeof(journalMagic));
+    LittleEndian::putU32(header + 4, VERSION);
+    LittleEndian::putU32(header + 8, generation);
+    bool started = writeBytes(header, HEADER_SIZE);
+    if (started)
+        m_size = HEADER_SIZE;
+    return started;
+}
+
+// Cuts the journal back to the end of the last good record and opens it for appending after that
+bool RegionJournal::openForAppend(std::size_t validSize)
+{
+    std::error_code error;
+    std::filesystem::resize_file(m_filename, validSize, error);
+    if (error)
+        return fail("Could not truncate " + m_filename + ": " + error.message());
+
+#ifdef _WIN32
+    m_fileStream.open(m_filename, std::ios::binary | std::ios::app);
+#else
+    m_fd = ::open(m_filename.c_str(), O_WRONLY | O_APPEND);
+#endif
+    if (!isOpen())
+        return fail("Could not open " + m_filename + ": " + std::strerror(errno));
+    return true;
+}
+
+void RegionJournal::close()
+{
+#ifdef _WIN32
+    if (m_fileStream.is_open())
+        m_fileStream.close();
+#else
+    if (m_fd >= 0)
+        ::close(m_fd);
+    m_fd = -1;
+#endif
+}
+
+// Writes a record, and if the journal has outgrown the compaction size, compacts it
+//
+// Return true if the record was written, otherwise false with the reason in getError().
+bool RegionJournal::append(const std::string& payload)
+{
+    if (!isOpen())
+        return fail("The journal is not open");
+
+    std::string record;
+    record.reserve(RECORD_HEADER_SIZE + payload.size());
+    appendU32(record, (std::uint32_t) payload.size());
+    appendU32(record, checksum(payload));
+    record += payload;
+
+    bool written = writeBytes(record.data(), record.size());
+    if (written)
+    {
+        m_size += record.size();
+        if (m_size > m_compactionSize)
+            compact();
+    }
+    return written;
+}
+
+// Writes the bytes in one go, and syncs them to disk if the journal was set up to
+bool RegionJournal::writeBytes(const char* bytes, std::size_t length)
+{
+#ifdef _WIN32
+    m_fileStream.write(bytes, (std::streamsize) length);
+    m_fileStream.flush();
+    if (!m_fileStream.good())
+        return fail("Could not write to " + m_filename);
+#else
+    while (length > 0)
+    {
+        ssize_t written = ::write(m_fd, bytes, length);
+        if (written < 0 && errno != EINTR)
+            return fail("Could not write to " + m_filename + ": " + std::strerror(errno));
+        if (written > 0)
+        {
+            bytes += written;
+            length -= (std::size_t) written;
+        }
+    }
+
+    if (m_syncToDisk && ::fsync(m_fd) != 0)
+        return fail("Could not sync " + m_filename + ": " + std::strerror(errno));
+#endif
+    return true;
+}
+
+// Return false, after saving the reason for the error
+bool RegionJournal::fail(const std::string& error)
+{
+    m_error = error;
+    return false;
+}
+
+// Return true if the region is the root of the journaled hierarchy or one of its descendants
+bool RegionJournal::isInHierarchy(const Region* region) const
+{
+    while (region != nullptr && region != m_root)
+        region = region->getParent();
+    return region != nullptr;
+}
+
+// 32-bit FNV-1a, which is plenty to tell a complete record from a torn one
+std::uint32_t RegionJournal::checksum(std::string_view bytes)
+{
+    std::uint32_t hash = 2166136261u;
+    for (char byte : bytes)
+    {
+        hash ^= (unsigned char) byte;
+        hash *= 16777619u;
+    }
+    return hash;
+}
@@ -0,0 +1,88 @@
+//
+// Append-only journal of the changes made to a region hierarchy since its last snapshot.
+//
+
+#ifndef GEO_REGIONS_REGION_JOURNAL_H
+#define GEO_REGIONS_REGION_JOURNAL_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+class Region;
+
+// Records every change to a hierarchy as it is made, so saving a change costs one small append instead of rewriting
+// the whole data file, and nothing is lost if the program doesn't get to exit normally.  On startup, the journal is
+// replayed on top of the snapshot it belongs to.  Once it grows past the compaction size, the hierarchy is written to
+// a new snapshot and the journal starts over.
+//
+// The journal and the snapshot carry the same generation number.  A journal whose generation doesn't match the
+// snapshot's is left over from a compaction that was interrupted after the new snapshot was written, so everything in
+// it is already in the snapshot and it is discarded.
+//
+//  Header (12 bytes):  magic "GEOJ", version, generation
+//  Record:             payload length, checksum of the payload, payload
+//
+// A record whose length or checksum doesn't check out is where the program stopped in the middle of an append, so
+// replaying stops there and the journal is cut back to the last complete record.
+class RegionJournal {
+public:
+    static const std::uint32_t VERSION = 1;
+    static const std::size_t HEADER_SIZE = 12;
+    static const std::size_t RECORD_HEADER_SIZE = 8;
+    static const std::size_t DEFAULT_COMPACTION_SIZE = 1 << 20;
+
+private:
+    typedef enum Operation { AddOperation = 1, NameOperation, PopulationOperation, AreaOperation,
+                             RemoveOperation, MoveOperation } x;
+
+    std::string     m_filename;
+    std::string     m_snapshotFile;
+    bool            m_syncToDisk;
+    std::size_t     m_compactionSize;
+    Region*         m_root = nullptr;
+    std::uint32_t   m_generation = 0;
+    std::size_t     m_size = 0;
+    int             m_fd = -1;
+    std::string     m_error;
+#ifdef _WIN32
+    std::ofstream   m_fileStream;
+#endif
+
+public:
+    RegionJournal(const std::string& filename, const std::string& snapshotFile, bool syncToDisk = true,
+                  std::size_t compactionSize = DEFAULT_COMPACTION_SIZE);
+    ~RegionJournal();
+    RegionJournal(const RegionJournal&) = delete;
+    RegionJournal& operator=(const RegionJournal&) = delete;
+
+    std::size_t open(Region& root, std::uint32_t generation, bool replay = true);
+    bool compact();
+
+    bool isOpen() const;
+    std::size_t getSize() const { return m_size; }
+    std::uint32_t getGeneration() const { return m_generation; }
+    const std::string& getError() const { return m_error; }
+
+    bool recordAdd(const Region& region);
+    bool recordName(const Region& region);
+    bool recordPopulation(const Region& region);
+    bool recordArea(const Region& region);
+    bool recordRemove(const Region& parent, unsigned int id);
+    bool recordMove(const Region& region);
+
+private:
+    std::size_t replayRecords(std::string_view journal);
+    bool apply(std::string_view payload);
+    bool start(std::uint32_t generation);
+    bool openForAppend(std::size_t validSize);
+    void close();
+    bool append(const std::string& payload);
+    bool writeBytes(const char* bytes, std::size_t length);
+    bool fail(const std::string& error);
+    bool isInHierarchy(const Region* region) const;
+    static std::uint32_t checksum(std::string_view bytes);
+};
+
+#endif //GEO_REGIONS_REGION_JOURNAL_H
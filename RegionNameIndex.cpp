@@ -0,0 +1,164 @@
+//
+// Index of region names for finding regions anywhere in a hierarchy.
+//
+
+#include "RegionNameIndex.h"
+#include "Region.h"
+#include "RegionVisitor.h"
+
+#include <algorithm>
+#include <cctype>
+#include <utility>
+
+struct RegionNameIndex::EntryBuilder : RegionVisitor<EntryBuilder> {
+    RegionNameIndex& index;
+
+    explicit EntryBuilder(RegionNameIndex& index) : index(index) {}
+
+    bool enter(const Region& region, unsigned int) { index.addEntry(region); return true; }
+};
+
+RegionNameIndex::RegionNameIndex(const Region& root)
+{
+    EntryBuilder(*this).visit(root);
+    std::sort(m_entries.begin(), m_entries.end(), [this](const Entry& a, const Entry& b) {
+        int comparison = getName(a).compare(getName(b));
+        return comparison < 0 || (comparison == 0 && a.id < b.id);
+    });
+}
+
+// Return the ids of the regions whose names match exactly, ignoring case
+std::vector<unsigned int> RegionNameIndex::findExact(std::string_view name) const
+{
+    std::string foldedName = foldCase(name);
+    std::vector<unsigned int> ids;
+    for (auto entry = lowerBound(foldedName); entry != m_entries.end() && getName(*entry) == foldedName; ++entry)
+        ids.push_back(entry->id);
+    return ids;
+}
+
+// Return the ids of the regions whose names start with the prefix, ignoring case
+std::vector<unsigned int> RegionNameIndex::findPrefix(std::string_view prefix) const
+{
+    std::string foldedPrefix = foldCase(prefix);
+    std::vector<unsigned int> ids;
+    for (auto entry = lowerBound(foldedPrefix);
+         entry != m_entries.end() && getName(*entry).substr(0, foldedPrefix.size()) == foldedPrefix; ++entry)
+        ids.push_back(entry->id);
+    return ids;
+}
+
+// Return the ids of the regions whose names are within maxDistance single-character insertions, deletions, or
+// substitutions of the name, ignoring case.  The closest matches come first.
+std::vector<unsigned int> RegionNameIndex::findFuzzy(std::string_view name, unsigned int maxDistance) const
+{
+    std::string foldedName = foldCase(name);
+    std::vector<std::pair<unsigned int, unsigned int>> matches;     // distance and id, in name order
+    std::string_view previousName;
+    unsigned int previousDistance = maxDistance + 1;
+    for (const Entry& entry : m_entries)
+    {
+        // Entries with the same name are next to each other, so each distinct name is only compared once
+        std::string_view entryName = getName(entry);
+        if (entryName != previousName || previousName.data() == nullptr)
+        {
+            std::size_t lengthDifference = (entryName.size() > foldedName.size()) ?
+                    entryName.size() - foldedName.size() : foldedName.size() - entryName.size();
+            previousDistance = (lengthDifference > maxDistance) ?
+                    maxDistance + 1 : editDistance(foldedName, entryName, maxDistance);
+            previousName = entryName;
+        }
+
+        if (previousDistance <= maxDistance)
+            matches.emplace_back(previousDistance, entry.id);
+    }
+
+    std::stable_sort(matches.begin(), matches.end(),
+                     [](const std::pair<unsigned int, unsigned int>& a, const std::pair<unsigned int, unsigned int>& b) {
+                         return a.first < b.first;
+                     });
+
+    std::vector<unsigned int> ids;
+    ids.reserve(matches.size());
+    for (const std::pair<unsigned int, unsigned int>& match : matches)
+        ids.push_back(match.second);
+    return ids;
+}
+
+std::string RegionNameIndex::foldCase(std::string_view name)
+{
+    std::string foldedName(name);
+    for (char& ch : foldedName)
+        ch = (char) std::tolower((unsigned char) ch);
+    return foldedName;
+}
+
+// Return the region with the given id and all of its ancestors, starting from the top of the hierarchy, or nothing
+// if there is no longer a region with that id
+std::vector<const Region*> RegionNameIndex::getAncestry(unsigned int id)
+{
+    std::vector<const Region*> ancestry;
+    for (const Region* region = Region::findById(id); region != nullptr; region = region->getParent())
+        ancestry.push_back(region);
+    std::reverse(ancestry.begin(), ancestry.end());
+    return ancestry;
+}
+
+// Return the names of the region with the given id and all of its ancestors, e.g., "World / United States / Utah"
+std::string RegionNameIndex::getPath(unsigned int id)
+{
+    std::string path;
+    for (const Region* region : getAncestry(id))
+    {
+        if (!path.empty())
+            path += " / ";
+        path += region->getName();
+    }
+    return path;
+}
+
+void RegionNameIndex::addEntry(const Region& region)
+{
+    std::string foldedName = foldCase(region.getName());
+    m_entries.push_back({ m_names.size(), foldedName.size(), region.getId() });
+    m_names += foldedName;
+}
+
+std::string_view RegionNameIndex::getName(const Entry& entry) const
+{
+    return std::string_view(m_names).substr(entry.nameOffset, entry.nameLength);
+}
+
+std::vector<RegionNameIndex::Entry>::const_iterator RegionNameIndex::lowerBound(std::string_view foldedName) const
+{
+    return std::lower_bound(m_entries.begin(), m_entries.end(), foldedName,
+                            [this](const Entry& entry, std::string_view name) { return getName(entry) < name; });
+}
+
+// Return the Levenshtein distance between a and b, or maxDistance + 1 as soon as it is clear that the distance is
+// more than maxDistance
+unsigned int RegionNameIndex::editDistance(std::string_view a, std::string_view b, unsigned int maxDistance)
+{
+    std::vector<unsigned int> previousRow(b.size() + 1);
+    std::vector<unsigned int> row(b.size() + 1);
+    for (std::size_t j=0; j<=b.size(); j++)
+        previousRow[j] = (unsigned int) j;
+
+    for (std::size_t i=1; i<=a.size(); i++)
+    {
+        row[0] = (unsigned int) i;
+        unsigned int rowMinimum = row[0];
+        for (std::size_t j=1; j<=b.size(); j++)
+        {
+            unsigned int substitution = previousRow[j-1] + (a[i-1] == b[j-1] ? 0 : 1);
+            row[j] = std::min(std::min(previousRow[j], row[j-1]) + 1, substitution);
+            rowMinimum = std::min(rowMinimum, row[j]);
+        }
+
+        if (rowMinimum > maxDistance)
+            return maxDistance + 1;
+        std::swap(row, previousRow);
+    }
+
+    return std::min(previousRow[b.size()], maxDistance + 1);
+}
@@ -0,0 +1,57 @@
+//
+// Index of region names for finding regions anywhere in a hierarchy.
+//
+
+#ifndef GEO_REGIONS_REGION_NAME_INDEX_H
+#define GEO_REGIONS_REGION_NAME_INDEX_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class Region;
+
+// Holds the name of every region in a hierarchy, folded to lower case and sorted, so that a name or prefix can be
+// found with a binary search no matter how deep the region is.  Lookups return region ids, in name order, which can
+// be turned into regions with Region::findById or into a readable path with getPath.
+//
+// The index is a picture of the hierarchy at the time it was built.  Regions added later aren't in it, and ids of
+// regions removed later no longer resolve to anything.
+class RegionNameIndex {
+public:
+    static const unsigned int DEFAULT_MAX_DISTANCE = 2;
+
+private:
+    struct Entry {
+        std::size_t     nameOffset;     // into m_names
+        std::size_t     nameLength;
+        unsigned int    id;
+    };
+
+    std::string         m_names;        // all of the folded names, back to back
+    std::vector<Entry>  m_entries;      // sorted by folded name, then id
+
+public:
+    explicit RegionNameIndex(const Region& root);
+
+    std::size_t size() const { return m_entries.size(); }
+
+    std::vector<unsigned int> findExact(std::string_view name) const;
+    std::vector<unsigned int> findPrefix(std::string_view prefix) const;
+    std::vector<unsigned int> findFuzzy(std::string_view name, unsigned int maxDistance = DEFAULT_MAX_DISTANCE) const;
+
+    static std::string foldCase(std::string_view name);
+    static std::vector<const Region*> getAncestry(unsigned int id);
+    static std::string getPath(unsigned int id);
+
+private:
+    struct EntryBuilder;
+
+    void addEntry(const Region& region);
+    std::string_view getName(const Entry& entry) const;
+    std::vector<Entry>::const_iterator lowerBound(std::string_view foldedName) const;
+    static unsigned int editDistance(std::string_view a, std::string_view b, unsigned int maxDistance);
+};
+
+#endif //GEO_REGIONS_REGION_NAME_INDEX_H
@@ -0,0 +1,266 @@
+//
+// Population, area, and density totals for every region of a hierarchy.
+//
+
+#include "RegionRollup.h"
+#include "Region.h"
+#include "BufferedWriter.h"
+#include "Instrumentation.h"
+#include "RegionVisitor.h"
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// A task rolls up one region.  It counts itself and each of its sub-region tasks as pending, and whoever brings
+// the count to zero fills in the region's totals and then finishes its parent in turn.
+struct RegionRollup::Task {
+    std::size_t             row;
+    Task*                   parent;
+    unsigned int            depth;
+    std::atomic<unsigned>   pending;
+
+    Task(std::size_t row, Task* parent, unsigned int depth) : row(row), parent(parent), depth(depth), pending(1) {}
+};
+
+// A worker's own tasks.  The owner takes its newest task from the back, where it is most likely still in the cache,
+// and other workers steal the oldest from the front, which tends to be the biggest piece of work left.
+struct RegionRollup::WorkQueue {
+    std::mutex          mutex;
+    std::deque<Task*>   tasks;
+    std::deque<Task>    storage;    // tasks created by this worker; a deque, so they never move
+};
+
+// Gives each region of the hierarchy a row, in the same order as a data file, and fills in the end of its subtree
+// once the rows for its sub-regions are in
+struct RegionRollup::RowNumbering : RegionVisitor<RowNumbering> {
+    RegionRollup&               rollup;
+    std::vector<std::size_t>    rows;       // the rows of the regions whose sub-regions are being numbered
+
+    explicit RowNumbering(RegionRollup& rollup) : rollup(rollup) {}
+
+    bool enter(const Region& region, unsigned int)
+    {
+        rows.push_back(rollup.m_regions.size());
+        rollup.m_regions.push_back(&region);
+        rollup.m_subtreeEnds.push_back(0);
+        return true;
+    }
+
+    void leave(const Region&, unsigned int)
+    {
+        rollup.m_subtreeEnds[rows.back()] = (std::uint32_t) rollup.m_regions.size();
+        rows.pop_back();
+    }
+};
+
+// Writes one report line per region
+struct RegionRollup::ReportWriter : RegionVisitor<ReportWriter> {
+    const RegionRollup& rollup;
+    BufferedWriter&     writer;
+    std::size_t         nextRow = 0;    // the row of the next region, unless the hierarchy has changed since
+
+    ReportWriter(const RegionRollup& rollup, BufferedWriter& writer) : rollup(rollup), writer(writer) {}
+
+    bool enter(const Region& region, unsigned int);
+};
+
+RegionRollup::RegionRollup(const Region& root, unsigned int threadCount) : m_root(root)
+{
+    INSTRUMENT_TIME(RollupTimer);
+    RowNumbering(*this).visit(root);
+    m_totals.resize(m_regions.size());
+
+    if (threadCount == 0)
+        threadCount = (m_regions.size() >= MIN_PARALLEL_REGIONS) ? std::thread::hardware_concurrency() : 1;
+
+    if (threadCount <= 1 || m_regions.size() == 1)
+    {
+        rollUpSubtree(0);
+        return;
+    }
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    for (unsigned int i=0; i<threadCount; i++)
+        queues.emplace_back(new WorkQueue());
+    std::atomic<bool> done(false);
+
+    Task* rootTask = &queues[0]->storage.emplace_back(0, nullptr, 0);
+    queues[0]->tasks.push_back(rootTask);
+
+    std::vector<std::thread> threads;
+    for (unsigned int i=1; i<threadCount; i++)
+        threads.emplace_back(&RegionRollup::work, this, std::ref(queues), i, std::ref(done));
+    work(queues, 0, done);
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+// Return the totals for a row, or all zeros for NO_ROW
+const RegionRollup::Totals& RegionRollup::getTotalsAt(std::size_t row) const
+{
+    static const Totals none;
+    return (row < m_totals.size()) ? m_totals[row] : none;
+}
+
+// Return the row of a region, or NO_ROW if it wasn't in the hierarchy when it was rolled up.  Walks that go in the
+// same order as a data file can pass the row after the previous region's as the hint, which is then all it checks.
+// Otherwise the region's ancestors are followed down from the root, looking only at the rows of sub-regions.
+std::size_t RegionRollup::findRow(const Region& region, std::size_t hint) const
+{
+    if (hint < m_regions.size() && m_regions[hint] == &region)
+        return hint;
+
+    std::vector<const Region*> path;
+    const Region* ancestor = &region;
+    for (; ancestor != nullptr && ancestor != &m_root; ancestor = ancestor->getParent())
+        path.push_back(ancestor);
+    if (ancestor == nullptr)
+        return NO_ROW;
+
+    std::size_t row = 0;
+    for (auto next = path.rbegin(); next != path.rend() && row != NO_ROW; ++next)
+    {
+        std::size_t subRow = row + 1;
+        while (subRow < m_subtreeEnds[row] && m_regions[subRow] != *next)
+            subRow = m_subtreeEnds[subRow];
+        row = (subRow < m_subtreeEnds[row]) ? subRow : NO_ROW;
+    }
+    return row;
+}
+
+// Writes one line per region, in the same order as a data file: id, parent id, type, name, and the totals.  The
+// parent id of the first region is left empty.
+void RegionRollup::writeReport(std::ostream& out) const
+{
+    BufferedWriter writer(out);
+    ReportWriter(*this, writer).visit(m_root);
+    writer.flush();
+}
+
+// Writes the report to a file, replacing it if it exists
+//
+// Return true if the whole report was written, otherwise false with the reason in error, if provided.
+bool RegionRollup::writeReport(const std::string& filename, std::string* error) const
+{
+    BufferedWriter writer(filename);
+    ReportWriter(*this, writer).visit(m_root);
+    bool written = writer.close();
+    if (!written && error != nullptr)
+        *error = writer.getError();
+    return written;
+}
+
+// The label comes from a table, so no string is built for each region
+bool RegionRollup::ReportWriter::enter(const Region& region, unsigned int depth)
+{
+    std::size_t row = rollup.findRow(region, nextRow);
+    nextRow = row + 1;
+    const Totals& totals = rollup.getTotalsAt(row);
+    writer.writeUnsigned(region.getId());
+    writer.write(',');
+    if (depth > 0 && region.getParent() != nullptr)
+        writer.writeUnsigned(region.getParent()->getId());
+    writer.write(',');
+    writer.write(Region::regionLabelView(region.getType()));
+    writer.write(',');
+    writer.write(region.getName());
+    writer.write(',');
+    writer.writeUnsigned(totals.population);
+    writer.write(',');
+    writer.writeDouble(totals.area);
+    writer.write(',');
+    writer.writeDouble(totals.density);
+    writer.write('\n');
+    return true;
+}
+
+// Runs tasks from this worker's queue, or stolen from the others, until the root task is finished
+void RegionRollup::work(std::vector<std::unique_ptr<WorkQueue>>& queues, unsigned int index, std::atomic<bool>& done)
+{
+    WorkQueue& queue = *queues[index];
+    while (!done.load(std::memory_order_acquire))
+    {
+        Task* task = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.tasks.empty())
+            {
+                task = queue.tasks.back();
+                queue.tasks.pop_back();
+            }
+        }
+
+        for (std::size_t i=1; task == nullptr && i<queues.size(); i++)
+        {
+            WorkQueue& victim = *queues[(index + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty())
+            {
+                task = victim.tasks.front();
+                victim.tasks.pop_front();
+            }
+        }
+
+        if (task != nullptr)
+            runTask(*task, queue, done);
+        else
+            std::this_thread::yield();
+    }
+}
+
+// Spawns a task for each sub-region that has sub-regions of its own, at least down to MAX_TASK_DEPTH, and rolls up
+// the rest right away
+void RegionRollup::runTask(Task& task, WorkQueue& queue, std::atomic<bool>& done)
+{
+    for (std::size_t subRow = task.row + 1; subRow < m_subtreeEnds[task.row]; subRow = m_subtreeEnds[subRow])
+    {
+        if (m_subtreeEnds[subRow] > subRow + 1 && task.depth + 1 < MAX_TASK_DEPTH)
+        {
+            task.pending.fetch_add(1, std::memory_order_relaxed);
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(&queue.storage.emplace_back(subRow, &task, task.depth + 1));
+        }
+        else
+        {
+            rollUpSubtree(subRow);
+        }
+    }
+
+    for (Task* finished = &task; finished != nullptr; finished = finished->parent)
+    {
+        if (finished->pending.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            break;
+
+        rollUp(finished->row);
+        if (finished->parent == nullptr)
+            done.store(true, std::memory_order_release);
+    }
+}
+
+// Fills in a row's totals from its region's own values and its sub-regions' totals, which must already be filled in.
+// Sub-regions added by a writer after the rows were numbered are left out.
+void RegionRollup::rollUp(std::size_t row)
+{
+    const Region& region = *m_regions[row];
+    Totals& totals = m_totals[row];
+    totals.population = region.getPopulation();
+    double subRegionArea = 0;
+    for (std::size_t subRow = row + 1; subRow < m_subtreeEnds[row]; subRow = m_subtreeEnds[subRow])
+    {
+        totals.population += m_totals[subRow].population;
+        subRegionArea += m_totals[subRow].area;
+    }
+
+    totals.area = (region.getArea() > 0) ? region.getArea() : subRegionArea;
+    totals.density = (totals.area > 0) ? (double) totals.population / totals.area : 0;
+}
+
+// Rolls up a subtree on the current thread.  Going backwards through its rows comes to each row after its sub-rows.
+void RegionRollup::rollUpSubtree(std::size_t row)
+{
+    for (std::size_t subRow = m_subtreeEnds[row]; subRow-- > row; )
+        rollUp(subRow);
+}
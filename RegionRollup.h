@@ -0,0 +1,76 @@
+//
+// Population, area, and density totals for every region of a hierarchy.
+//
+
+#ifndef GEO_REGIONS_REGION_ROLLUP_H
+#define GEO_REGIONS_REGION_ROLLUP_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class BufferedWriter;
+class Region;
+
+// Computes the totals for a region and all of its sub-regions in one bottom-up pass:
+//
+//  population  the region's own population plus the total population of all of its sub-regions
+//  area        the region's own area, or if it doesn't have one, the total area of its sub-regions
+//  density     population / area, or 0 if the area is 0
+//
+// Large hierarchies are split into one task per region that has sub-regions, down to the county level, and those
+// tasks are run by a pool of threads that each keep their own queue and steal from the others when theirs runs dry.
+// A region's totals are filled in by whichever thread finishes its last sub-region task, so no thread ever waits.
+// Smaller hierarchies are rolled up on the calling thread, since starting the pool would cost more than the work.
+//
+// The regions are first given rows in the same order as a data file, each with the end of its subtree, so the
+// sub-regions of a row are found, and their totals read, by plain array indexing.
+//
+// The totals are a picture of the hierarchy at the time they were computed; they don't follow later changes.
+class RegionRollup {
+public:
+    struct Totals {
+        unsigned long long  population = 0;
+        double              area = 0;
+        double              density = 0;
+    };
+
+    static const unsigned int MAX_TASK_DEPTH = 4;   // regions deeper than this are rolled up by their ancestor's task
+    static const std::size_t MIN_PARALLEL_REGIONS = 1 << 14;    // fewer regions than this are rolled up on one thread
+    static const std::size_t NO_ROW = (std::size_t) -1;
+
+private:
+    const Region&                   m_root;
+    std::vector<const Region*>      m_regions;      // one row for each region, in the order of a data file
+    std::vector<std::uint32_t>      m_subtreeEnds;  // one past the last row of each row's subtree
+    std::vector<Totals>             m_totals;       // by row
+
+public:
+    explicit RegionRollup(const Region& root, unsigned int threadCount = 0);
+
+    std::size_t getRegionCount() const { return m_regions.size(); }
+
+    const Region& getRoot() const { return m_root; }
+    const Totals& getTotals(const Region& region) const { return getTotalsAt(findRow(region)); }
+    const Totals& getTotalsAt(std::size_t row) const;
+    std::size_t findRow(const Region& region, std::size_t hint = 0) const;
+
+    void writeReport(std::ostream& out) const;
+    bool writeReport(const std::string& filename, std::string* error = nullptr) const;
+
+private:
+    struct Task;
+    struct WorkQueue;
+    struct RowNumbering;
+    struct ReportWriter;
+
+    void work(std::vector<std::unique_ptr<WorkQueue>>& queues, unsigned int index, std::atomic<bool>& done);
+    void runTask(Task& task, WorkQueue& queue, std::atomic<bool>& done);
+    void rollUp(std::size_t row);
+    void rollUpSubtree(std::size_t row);
+};
+
+#endif //GEO_REGIONS_REGION_ROLLUP_H
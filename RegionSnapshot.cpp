@@ -0,0 +1,171 @@
+//
+// Binary snapshot format for a region hierarchy.
+//
+
+#include "RegionSnapshot.h"
+#include "LittleEndian.h"
+#include "Region.h"
+#include "RegionVisitor.h"
+#include "World.h"
+
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace
+{
+    const char snapshotMagic[4] = { 'G', 'E', 'O', 'R' };
+}
+
+// Appends the records for a region and its sub-regions, in pre-order, along with their names.  A record's subtree end
+// is filled in once the records for its sub-regions are in.
+struct RegionSnapshot::RecordWriter : RegionVisitor<RecordWriter> {
+    std::string&                records;
+    std::string&                names;
+    std::vector<std::size_t>    recordStarts;   // the records of the regions whose sub-regions are being appended
+    bool                        isValid = true; // false once the snapshot would outgrow the 32-bit offsets
+
+    RecordWriter(std::string& records, std::string& names) : records(records), names(names) {}
+
+    bool enter(const Region& region, unsigned int)
+    {
+        const std::size_t maxSize = std::numeric_limits<std::uint32_t>::max();
+        isValid = isValid && names.size() + region.getName().size() <= maxSize &&
+                  records.size() / RECORD_SIZE < maxSize;
+        if (!isValid)
+        {
+            recordStarts.push_back(records.size());
+            return false;
+        }
+
+        std::size_t recordStart = records.size();
+        records.resize(recordStart + RECORD_SIZE);
+        char* record = &records[recordStart];
+        LittleEndian::putU32(record, region.getId());
+        LittleEndian::putU32(record + 4, (std::uint32_t) region.getType());
+        LittleEndian::putU32(record + 8, region.getPopulation());
+        LittleEndian::putU32(record + 12, (std::uint32_t) names.size());
+        LittleEndian::putU32(record + 16, (std::uint32_t) region.getName().size());
+        LittleEndian::putF64(record + 24, region.getArea());
+        names += region.getName();
+        recordStarts.push_back(recordStart);
+        return true;
+    }
+
+    void leave(const Region&, unsigned int)
+    {
+        if (isValid)
+            LittleEndian::putU32(&records[recordStarts.back() + 20], (std::uint32_t) (records.size() / RECORD_SIZE));
+        recordStarts.pop_back();
+    }
+};
+
+// Writes the region and all of its sub-regions as a snapshot, tagged with a generation number that a journal of later
+// changes can be matched against
+//
+// Return true if the whole snapshot was written, otherwise false.
+bool RegionSnapshot::write(const Region& root, std::ostream& out, std::uint32_t generation)
+{
+    std::string records;
+    std::string names;
+    RecordWriter writer(records, names);
+    writer.visit(root);
+    if (!writer.isValid)
+        return false;
+
+    char header[HEADER_SIZE] = {};
+    std::memcpy(header, snapshotMagic, sizeof(snapshotMagic));
+    LittleEndian::putU32(header + 4, VERSION);
+    LittleEndian::putU32(header + 8, Region::m_nextId);
+    LittleEndian::putU32(header + 12, (std::uint32_t) (records.size() / RECORD_SIZE));
+    LittleEndian::putU32(header + 16, (std::uint32_t) names.size());
+    LittleEndian::putU32(header + 20, generation);
+
+    out.write(header, HEADER_SIZE);
+    out.write(records.data(), records.size());
+    out.write(names.data(), names.size());
+    out.flush();
+    return out.good();
+}
+
+// Rebuilds a region hierarchy from a snapshot.  If useArena is true and the root is a world, the other regions are
+// allocated from the world's arena.  If generation is provided, it is set to the snapshot's generation number.
+//
+// Return the root region, or nullptr if the snapshot is malformed or from an unknown version.
+Region* RegionSnapshot::read(std::string_view snapshot, bool useArena, std::uint32_t* generation)
+{
+    if (snapshot.size() < HEADER_SIZE || std::memcmp(snapshot.data(), snapshotMagic, sizeof(snapshotMagic)) != 0 ||
+        LittleEndian::getU32(snapshot.data() + 4) != VERSION)
+        return nullptr;
+
+    std::uint32_t nextId = LittleEndian::getU32(snapshot.data() + 8);
+    std::uint32_t recordCount = LittleEndian::getU32(snapshot.data() + 12);
+    std::uint32_t nameTableSize = LittleEndian::getU32(snapshot.data() + 16);
+    if (recordCount == 0 || snapshot.size() != HEADER_SIZE + (std::size_t) recordCount * RECORD_SIZE + nameTableSize ||
+        !Region::isPlausibleId(nextId, recordCount))
+        return nullptr;
+
+    // Every record's id is below the snapshot's next id, which is plausible for the record count, so the ids can keep
+    // their slots in the registry.  The ids handed out while reading are given back if the snapshot is rejected.
+    unsigned int previousNextId = Region::m_nextId;
+    const char* records = snapshot.data() + HEADER_SIZE;
+    std::string_view names = snapshot.substr(HEADER_SIZE + (std::size_t) recordCount * RECORD_SIZE);
+
+    // Each entry is a region that is still receiving sub-regions, with the end of its subtree
+    std::vector<std::pair<Region*, std::uint32_t>> ancestors;
+    Region* root = nullptr;
+    RegionArena* arena = nullptr;
+    bool isValid = true;
+    for (std::uint32_t i=0; i<recordCount && isValid; i++)
+    {
+        const char* record = records + (std::size_t) i * RECORD_SIZE;
+        std::uint32_t nameOffset = LittleEndian::getU32(record + 12);
+        std::uint32_t nameLength = LittleEndian::getU32(record + 16);
+        std::uint32_t subtreeEnd = LittleEndian::getU32(record + 20);
+        std::uint32_t id = LittleEndian::getU32(record);
+
+        while (!ancestors.empty() && ancestors.back().second <= i)
+            ancestors.pop_back();
+
+        std::uint32_t limit = ancestors.empty() ? recordCount : ancestors.back().second;
+        Region::RegionType regionType = (Region::RegionType) LittleEndian::getU32(record + 4);
+        isValid = (id < nextId && subtreeEnd > i && subtreeEnd <= limit && (i == 0 || !ancestors.empty()) &&
+                   (std::size_t) nameOffset + nameLength <= names.size() &&
+                   (ancestors.empty() || Region::canContain(ancestors.back().first->getType(), regionType)));
+        if (isValid)
+        {
+            Region* region = Region::createWithId(id, regionType, names.substr(nameOffset, nameLength),
+                                                  LittleEndian::getU32(record + 8), LittleEndian::getF64(record + 24),
+                                                  arena, recordCount);
+            isValid = (region != nullptr);
+            if (isValid)
+            {
+                if (root == nullptr)
+                {
+                    root = region;
+                    if (useArena && root->getType() == Region::WorldType)
+                        arena = static_cast<World*>(root)->useArena();
+                }
+                else
+                    ancestors.back().first->addSubregion(region);
+                ancestors.emplace_back(region, subtreeEnd);
+            }
+        }
+    }
+
+    if (!isValid)
+    {
+        delete root;
+        root = nullptr;
+        Region::m_nextId = previousNextId;
+    }
+    else
+    {
+        if (nextId > Region::m_nextId)
+            Region::m_nextId = nextId;
+        if (generation != nullptr)
+            *generation = LittleEndian::getU32(snapshot.data() + 20);
+    }
+
+    return root;
+}
@@ -0,0 +1,35 @@
+//
+// Binary snapshot format for a region hierarchy.
+//
+
+#ifndef GEO_REGIONS_REGION_SNAPSHOT_H
+#define GEO_REGIONS_REGION_SNAPSHOT_H
+
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
+class Region;
+
+// A snapshot is a header, followed by one fixed-width record per region in pre-order, followed by a table holding all
+// of the region names back to back.  All numbers are little-endian.
+//
+//  Header (24 bytes):  magic "GEOR", version, next id, record count, name table size, generation
+//  Record (32 bytes):  id, type, population, name offset, name length, subtree end, area (8 bytes)
+//
+// A record's subtree end is the index of the first record after all of its descendants, so the first child of record
+// i is record i+1, and each following sibling starts at the previous sibling's subtree end.
+class RegionSnapshot {
+public:
+    static const std::uint32_t VERSION = 1;
+    static const std::size_t HEADER_SIZE = 24;
+    static const std::size_t RECORD_SIZE = 32;
+
+    static bool write(const Region& root, std::ostream& out, std::uint32_t generation = 0);
+    static Region* read(std::string_view snapshot, bool useArena = false, std::uint32_t* generation = nullptr);
+
+private:
+    struct RecordWriter;
+};
+
+#endif //GEO_REGIONS_REGION_SNAPSHOT_H
@@ -0,0 +1,38 @@
+//
+// Walks over a region hierarchy, with the calls for each region bound at compile time.
+//
+
+#ifndef GEO_REGIONS_REGION_VISITOR_H
+#define GEO_REGIONS_REGION_VISITOR_H
+
+#include "Region.h"
+
+// Base for a walk over a region and all of its sub-regions, in the same order as a data file.  The derived class
+// passes itself as the template parameter and defines enter(), which is called on each region before its
+// sub-regions, and leave(), which is called after them.  Either one can be left out.  The depth is 0 for the region
+// the walk starts at.
+//
+// The calls are bound at compile time rather than through virtual functions, so they can be inlined into the walk,
+// which then costs no more than a hand-written recursive loop over the sub-regions.  enter() can return false to
+// skip a region's sub-regions; leave() is still called for the region.
+//
+// A walk can run while a writer changes the hierarchy, under a RegionEpoch::ReadGuard, like any other reader.
+template <typename Derived>
+class RegionVisitor {
+public:
+    void visit(const Region& region, unsigned int depth = 0)
+    {
+        Derived& derived = static_cast<Derived&>(*this);
+        if (derived.enter(region, depth))
+        {
+            for (const Region* subRegion : region.m_subRegions)
+                visit(*subRegion, depth + 1);
+        }
+        derived.leave(region, depth);
+    }
+
+    bool enter(const Region&, unsigned int) { return true; }
+    void leave(const Region&, unsigned int) {}
+};
+
+#endif //GEO_REGIONS_REGION_VISITOR_H
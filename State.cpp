@@ -5,7 +5,12 @@
 #include "State.h"
 
 // DONE: implement State class functionality
-State::State(const std::string data[]) : Region(StateType, data)
+State::State(const std::string_view data[]) : Region(StateType, data)
+{
+    validate();
+}
+
+State::State(std::string_view name, unsigned int population, double area) : Region(StateType, name, population, area)
 {
     validate();
 }
@@ -8,11 +8,15 @@
 #include "Region.h"
 
 #include <string>
+#include <string_view>
 
 class State : public Region
 {
 public:
-    State(const std::string data[]);
+    static constexpr RegionType regionType = StateType;
+
+    State(const std::string_view data[]);
+    State(std::string_view name, unsigned int population, double area);
 };
 
 #endif //GEO_REGIONS_STATE_H
@@ -9,8 +9,8 @@
 
 #include <iostream>
 
-StateUserInterface::StateUserInterface(Region* contextRegion) :
-        UserInterface(contextRegion)
+StateUserInterface::StateUserInterface(Region* contextRegion, RegionJournal* journal) :
+        UserInterface(contextRegion, journal)
 {
 
 }
@@ -37,6 +37,7 @@ void StateUserInterface::setupMenu()
     m_menu->addOption("L", "List all counties or cities in this state");
     m_menu->addOption("E", "Edit a county or city");
     m_menu->addOption("D", "Delete a county or city");
+    m_menu->addOption("R", "Relocate a county or city to another state or county");
     m_menu->addOption("P", "Print a report containing all counties or cities in this state");
     m_menu->addOption("M", "Move into the context of a county or city");
 }
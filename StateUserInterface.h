@@ -10,7 +10,7 @@
 class StateUserInterface : public UserInterface
 {
 public:
-    StateUserInterface(Region* contextRegion);
+    StateUserInterface(Region* contextRegion, RegionJournal* journal = nullptr);
 
     Region::RegionType getSubRegionType();
     void setupMenu();
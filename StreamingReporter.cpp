@@ -0,0 +1,202 @@
+//
+// Reports straight from a data file, without loading it.
+//
+
+#include "StreamingReporter.h"
+#include "BufferedWriter.h"
+#include "Region.h"
+#include "World.h"
+#include "Utils.h"
+
+#include <charconv>
+#include <fstream>
+
+namespace
+{
+    const std::size_t TAB_SIZE = 4;
+    const std::size_t ID_WIDTH = 6;
+}
+
+// Writes a report of the region at the start of the input and all of its sub-regions
+//
+// Return false if the first line of the input isn't a valid region, or the report couldn't be written.
+bool StreamingReporter::write(std::istream& in, std::ostream& out, ReportType reportType, unsigned int firstId)
+{
+    BufferedWriter writer(out);
+    StreamingReporter reporter(writer, reportType, firstId);
+    bool written = reporter.run(in);
+    return writer.flush() && written;
+}
+
+// Writes a report of a data file to an output file, replacing it if it exists
+//
+// Return false with the reason in error, if provided, if the data file couldn't be read, its first line isn't a valid
+// region, or the report couldn't be written.
+bool StreamingReporter::write(const std::string& inputFile, const std::string& outputFile, ReportType reportType,
+                              unsigned int firstId, std::string* error)
+{
+    std::ifstream in(inputFile);
+    if (!in.is_open())
+    {
+        if (error != nullptr)
+            *error = "could not open " + inputFile;
+        return false;
+    }
+
+    BufferedWriter writer(outputFile);
+    StreamingReporter reporter(writer, reportType, firstId);
+    bool isValid = reporter.run(in);
+    bool written = writer.close();
+    if (error != nullptr)
+    {
+        if (!isValid)
+            *error = inputFile + " does not start with a valid region";
+        else if (!written)
+            *error = writer.getError();
+    }
+    return isValid && written;
+}
+
+StreamingReporter::StreamingReporter(BufferedWriter& writer, ReportType reportType, unsigned int firstId) :
+        m_writer(writer), m_reportType(reportType), m_nextId(firstId)
+{
+}
+
+// Reads the lines the same way Region::load does: a ^^^ closes the current region's list of sub-regions, lines that
+// aren't valid regions are skipped, regions that can't be in the current region are skipped along with their
+// sub-regions, and reading stops once the root's list is closed.  Regions left open at the end of the input are
+// closed there.
+bool StreamingReporter::run(std::istream& in)
+{
+    std::string line;
+    bool isValid = false;
+    if (std::getline(in, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        isValid = open(line);
+    }
+
+    while (!m_ancestors.empty() && std::getline(in, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+
+        if (m_skipDepth > 0)
+            skip(line);
+        else if (line == Region::regionDelimiter)
+            close();
+        else
+            open(line);
+    }
+
+    while (!m_ancestors.empty())
+        close();
+    return isValid;
+}
+
+// Starts a region, if the line is one, using the same rules as Region::create.  An id is used up by any line with a
+// known region type and three fields, even if the values aren't valid, since creating a region does the same.
+//
+// Return true if the line was a valid region.
+bool StreamingReporter::open(std::string_view line)
+{
+    std::size_t commaPos = line.find(',');
+    if (commaPos == std::string_view::npos)
+        return false;
+
+    bool isValid;
+    int regionType = parseInt(line.substr(0, commaPos), &isValid);
+    if (!isValid || regionType < Region::WorldType || regionType > Region::CityType)
+        return false;
+
+    // A region that can't be here is rejected before it uses up an id, and so are its sub-regions
+    if (!m_ancestors.empty() &&
+        !Region::canContain((Region::RegionType) m_ancestors.back().regionType, (Region::RegionType) regionType))
+    {
+        m_skipDepth = 1;
+        return false;
+    }
+
+    std::string_view fields[3];
+    if (!split(line.substr(commaPos + 1), ',', fields, 3))
+        return false;
+
+    // A world is always created with the default values, no matter what is in the file
+    if (regionType == Region::WorldType)
+    {
+        for (int i=0; i<3; i++)
+            fields[i] = World::defaultData[i];
+    }
+
+    unsigned int id = m_nextId++;
+    unsigned int population = parseUnsignedInt(fields[1], &isValid);
+    double area = isValid ? parseDouble(fields[2]) : 0;
+    if (area == 0 || fields[0].empty() || area < 0)
+        return false;
+
+    m_ancestors.push_back({ id, regionType, std::string(fields[0]), population, area, population, 0 });
+    if (m_reportType == ListReport)
+        writeLine(m_ancestors.back(), m_ancestors.size() - 1);
+    return true;
+}
+
+// Finishes the innermost open region and adds its totals to its parent's
+void StreamingReporter::close()
+{
+    Ancestor region = std::move(m_ancestors.back());
+    m_ancestors.pop_back();
+    if (region.area <= 0)
+        region.area = region.subRegionArea;
+
+    if (m_reportType == DisplayReport)
+        writeLine(region, m_ancestors.size());
+
+    if (!m_ancestors.empty())
+    {
+        m_ancestors.back().totalPopulation += region.totalPopulation;
+        m_ancestors.back().subRegionArea += region.area;
+    }
+}
+
+// Follows the nesting of a skipped subtree the same way Region::skipSubtree does
+void StreamingReporter::skip(std::string_view line)
+{
+    if (line == Region::regionDelimiter)
+        m_skipDepth--;
+    else if (line.find(',') != std::string_view::npos)
+        m_skipDepth++;
+}
+
+void StreamingReporter::writeLine(const Ancestor& region, std::size_t level)
+{
+    char id[16];
+    std::to_chars_result result = std::to_chars(id, id + sizeof(id), region.id);
+    std::size_t idLength = result.ptr - id;
+
+    if (m_reportType == ListReport)
+    {
+        m_writer.write('\n');
+        m_writer.write(std::string_view(id, idLength));
+        m_writer.write(' ');
+        m_writer.write(region.name);
+        m_writer.write(":\n");
+    }
+    else
+    {
+        for (std::size_t i=0; i<level * TAB_SIZE; i++)
+            m_writer.write(' ');
+        for (std::size_t i=idLength; i<ID_WIDTH; i++)
+            m_writer.write(' ');
+        m_writer.write(std::string_view(id, idLength));
+        m_writer.write("  ");
+        m_writer.write(region.name);
+        m_writer.write(", population=");
+        m_writer.writeUnsigned(region.totalPopulation);
+        m_writer.write(", area=");
+        m_writer.writeDouble(region.area);
+        m_writer.write(", density=");
+        m_writer.writeDouble((region.area > 0) ? (double) region.totalPopulation / region.area : 0);
+        m_writer.write('\n');
+    }
+}
@@ -0,0 +1,60 @@
+//
+// Reports straight from a data file, without loading it.
+//
+
+#ifndef GEO_REGIONS_STREAMING_REPORTER_H
+#define GEO_REGIONS_STREAMING_REPORTER_H
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class BufferedWriter;
+
+// Writes the same lines as Region::list or Region::display while reading a data file one line at a time.  Only the
+// chain of regions from the root down to the current line is kept, so memory use depends on how deep the hierarchy
+// is, not how big it is, and files bigger than memory can be reported on.
+//
+// Ids are handed out the same way loading the file would hand them out, starting from firstId.  List lines are
+// written as each region is read, in file order.  Display lines need the totals of a region's whole subtree, so they
+// are written as each region's list of sub-regions is closed, i.e., each region comes after its sub-regions.  The
+// totals are the same ones RegionRollup computes.
+class StreamingReporter {
+public:
+    typedef enum ReportType { ListReport, DisplayReport } x;
+
+private:
+    struct Ancestor {
+        unsigned int        id;
+        int                 regionType;
+        std::string         name;
+        unsigned int        population;
+        double              area;
+        unsigned long long  totalPopulation;
+        double              subRegionArea;
+    };
+
+    BufferedWriter&         m_writer;
+    ReportType              m_reportType;
+    unsigned int            m_nextId;
+    std::vector<Ancestor>   m_ancestors;
+    unsigned int            m_skipDepth = 0;    // lists still open in a subtree that is being skipped
+
+public:
+    static bool write(std::istream& in, std::ostream& out, ReportType reportType, unsigned int firstId = 0);
+    static bool write(const std::string& inputFile, const std::string& outputFile, ReportType reportType,
+                      unsigned int firstId = 0, std::string* error = nullptr);
+
+private:
+    StreamingReporter(BufferedWriter& writer, ReportType reportType, unsigned int firstId);
+
+    bool run(std::istream& in);
+    bool open(std::string_view line);
+    void close();
+    void skip(std::string_view line);
+    void writeLine(const Ancestor& region, std::size_t level);
+};
+
+#endif //GEO_REGIONS_STREAMING_REPORTER_H
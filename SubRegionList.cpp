@@ -0,0 +1,163 @@
+//
+// Growable list of sub-region pointers owned by a Region.
+//
+
+#include "SubRegionList.h"
+#include "Region.h"
+#include "RegionEpoch.h"
+
+#include <new>
+
+SubRegionList::SubRegionList() : m_block(&m_inlineBlock)
+{
+    m_inlineBlock.capacity = INLINE_CAPACITY;
+    m_inlineBlock.items = m_inline;
+    for (std::atomic<Region*>& item : m_inline)
+        item.store(nullptr, std::memory_order_relaxed);
+}
+
+// Nothing can be reading a list that is being destroyed, so its storage is freed right away
+SubRegionList::~SubRegionList()
+{
+    Block* block = getBlock();
+    if (!isInline(block))
+        freeBlock(block);
+}
+
+void SubRegionList::add(Region* region)
+{
+    Block* block = getBlock();
+    unsigned int count = block->count.load(std::memory_order_relaxed);
+    if (count == block->capacity)
+    {
+        // Compacting makes room if at least half of the block is holes, otherwise the block has to grow
+        unsigned int removed = block->removed.load(std::memory_order_relaxed);
+        bool mostlyHoles = !isInline(block) && 2 * removed >= block->capacity;
+        rebuild(mostlyHoles ? block->capacity : 2 * block->capacity);
+        block = getBlock();
+        count = block->count.load(std::memory_order_relaxed);
+    }
+
+    // Readers only look as far as the count they see, so the new slot is filled in before the count includes it
+    region->m_indexInParent = count;
+    block->items[count].store(region, std::memory_order_release);
+    block->count.store(count + 1, std::memory_order_release);
+}
+
+// Takes the region out of the list in O(1), by clearing the slot it remembers.  The region itself is not deleted.
+//
+// Return true if the region was in the list, otherwise false.
+bool SubRegionList::remove(Region* region)
+{
+    Block* block = getBlock();
+    unsigned int count = block->count.load(std::memory_order_relaxed);
+    unsigned int index = region->m_indexInParent;
+    bool found = (index < count && block->items[index].load(std::memory_order_relaxed) == region);
+    if (found)
+    {
+        block->items[index].store(nullptr, std::memory_order_release);
+        unsigned int removed = block->removed.load(std::memory_order_relaxed) + 1;
+        block->removed.store(removed, std::memory_order_release);
+        if (!isInline(block) && 2 * removed > count)
+            rebuild(block->capacity);
+    }
+    return found;
+}
+
+// Forgets all of the pointers and gives back any heap storage.  The regions themselves are not deleted.  Like the
+// destructor, this is only for a list that nothing is reading.
+void SubRegionList::clear()
+{
+    Block* block = getBlock();
+    if (!isInline(block))
+        freeBlock(block);
+
+    m_inlineBlock.count.store(0, std::memory_order_relaxed);
+    m_inlineBlock.removed.store(0, std::memory_order_relaxed);
+    m_block.store(&m_inlineBlock, std::memory_order_release);
+}
+
+unsigned int SubRegionList::size() const
+{
+    const Block* block = getBlock();
+    unsigned int removed = block->removed.load(std::memory_order_acquire);
+    return block->count.load(std::memory_order_acquire) - removed;
+}
+
+// Return the sub-region at the index, counting only the regions still in the list, or nullptr if the index is past
+// the end of the list.  This is O(1) unless regions have been removed since the list was last compacted.
+Region* SubRegionList::at(unsigned int index) const
+{
+    const Block* block = getBlock();
+    unsigned int removed = block->removed.load(std::memory_order_acquire);
+    unsigned int count = block->count.load(std::memory_order_acquire);
+    Region* result = nullptr;
+    if (removed == 0)
+    {
+        if (index < count)
+            result = block->items[index].load(std::memory_order_acquire);
+    }
+    else
+    {
+        for (unsigned int i=0; i<count && result == nullptr; i++)
+        {
+            Region* item = block->items[i].load(std::memory_order_acquire);
+            if (item != nullptr && index-- == 0)
+                result = item;
+        }
+    }
+    return result;
+}
+
+SubRegionList::Iterator SubRegionList::begin() const
+{
+    const Block* block = getBlock();
+    return Iterator(block->items, block->count.load(std::memory_order_acquire));
+}
+
+// Moves the regions, without the holes between them, to a new heap block, and tells each region its new slot
+void SubRegionList::rebuild(unsigned int capacity)
+{
+    Block* block = getBlock();
+    unsigned int count = block->count.load(std::memory_order_relaxed);
+    Block* rebuilt = allocateBlock(capacity);
+    unsigned int copied = 0;
+    for (unsigned int i=0; i<count; i++)
+    {
+        Region* region = block->items[i].load(std::memory_order_relaxed);
+        if (region != nullptr)
+        {
+            region->m_indexInParent = copied;
+            rebuilt->items[copied++].store(region, std::memory_order_relaxed);
+        }
+    }
+    rebuilt->count.store(copied, std::memory_order_relaxed);
+    replaceBlock(rebuilt);
+}
+
+// Publishes a new block, and retires the old one if it came from the heap
+void SubRegionList::replaceBlock(Block* block)
+{
+    Block* oldBlock = getBlock();
+    m_block.store(block, std::memory_order_release);
+    if (!isInline(oldBlock))
+        RegionEpoch::retire(oldBlock, freeBlock);
+}
+
+// A heap block is its header followed by the pointers, in one allocation
+SubRegionList::Block* SubRegionList::allocateBlock(unsigned int capacity)
+{
+    void* memory = ::operator new(sizeof(Block) + capacity * sizeof(std::atomic<Region*>));
+    Block* block = new (memory) Block();
+    block->capacity = capacity;
+    block->items = new (block + 1) std::atomic<Region*>[capacity];
+    for (unsigned int i=0; i<capacity; i++)
+        block->items[i].store(nullptr, std::memory_order_relaxed);
+    return block;
+}
+
+void SubRegionList::freeBlock(void* block)
+{
+    static_cast<Block*>(block)->~Block();
+    ::operator delete(block);
+}
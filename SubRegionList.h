@@ -0,0 +1,105 @@
+//
+// Growable list of sub-region pointers owned by a Region.
+//
+
+#ifndef GEO_REGIONS_SUB_REGION_LIST_H
+#define GEO_REGIONS_SUB_REGION_LIST_H
+
+#include <atomic>
+
+class Region;
+
+// Holds the children of a region.  The first few pointers are stored inline, so leaf regions (e.g., cities) and
+// small parents never touch the heap.  Beyond that, storage is moved to a heap block that doubles in size, which keeps
+// add() amortized O(1).
+//
+// Each region remembers its slot in its parent's list, so removing it is O(1): its slot is cleared, leaving a hole
+// that iteration skips.  Once holes make up more than half of a heap block, the remaining regions are moved to a new
+// block, in order, which keeps removal amortized O(1) and the list in the order the regions were added.
+//
+// The list can be read while one writer changes it (see RegionEpoch).  The pointers and their count live together
+// in a block, and readers take the block and its count once, when they start iterating, so they always see a
+// consistent list.  Adding writes past the end of the current block before publishing the new count, and removing
+// clears a single slot.  Compacting, or outgrowing the block, builds a new block and publishes it in one store, and
+// the old block is retired rather than freed.  Once a list has moved to the heap, it never goes back to its inline
+// block until it is cleared.
+class SubRegionList {
+public:
+    static const unsigned int INLINE_CAPACITY = 4;
+
+private:
+    struct Block {
+        std::atomic<unsigned int>   count{0};       // slots used, including holes
+        std::atomic<unsigned int>   removed{0};     // holes
+        unsigned int                capacity = 0;
+        std::atomic<Region*>*       items = nullptr;
+    };
+
+public:
+    // Iterates over the list as it was when begin() was called, skipping holes.  end() is a sentinel that any
+    // finished iterator compares equal to.
+    class Iterator {
+    private:
+        const std::atomic<Region*>*     m_items;
+        unsigned int                    m_count;
+        unsigned int                    m_index;
+        Region*                         m_current;
+
+    public:
+        Iterator(const std::atomic<Region*>* items, unsigned int count) :
+                m_items(items), m_count(count), m_index(0), m_current(nullptr) { skipHoles(); }
+
+        Region* operator*() const { return m_current; }
+        Iterator& operator++() { m_index++; skipHoles(); return *this; }
+        bool isAtEnd() const { return m_index >= m_count; }
+        bool operator==(const Iterator& other) const
+        {
+            return isAtEnd() ? other.isAtEnd() : !other.isAtEnd() && m_items == other.m_items && m_index == other.m_index;
+        }
+        bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+    private:
+        void skipHoles()
+        {
+            for (; m_index < m_count; m_index++)
+            {
+                m_current = m_items[m_index].load(std::memory_order_acquire);
+                if (m_current != nullptr)
+                    break;
+            }
+        }
+    };
+
+private:
+    std::atomic<Block*>     m_block;
+    Block                   m_inlineBlock;
+    std::atomic<Region*>    m_inline[INLINE_CAPACITY];
+
+public:
+    SubRegionList();
+    ~SubRegionList();
+    SubRegionList(const SubRegionList&) = delete;
+    SubRegionList& operator=(const SubRegionList&) = delete;
+
+    void add(Region* region);
+    bool remove(Region* region);
+    void clear();
+
+    unsigned int size() const;
+    bool empty() const { return size() == 0; }
+    unsigned int capacity() const { return getBlock()->capacity; }
+    Region* at(unsigned int index) const;
+
+    Iterator begin() const;
+    Iterator end() const { return Iterator(nullptr, 0); }
+
+private:
+    Block* getBlock() const { return m_block.load(std::memory_order_acquire); }
+    bool isInline(const Block* block) const { return block == &m_inlineBlock; }
+    void rebuild(unsigned int capacity);
+    void replaceBlock(Block* block);
+    static Block* allocateBlock(unsigned int capacity);
+    static void freeBlock(void* block);
+};
+
+#endif //GEO_REGIONS_SUB_REGION_LIST_H
@@ -5,9 +5,32 @@
 #include "RegionTester.h"
 
 #include "../Region.h"
+#include "../World.h"
+#include "../City.h"
+#include "../County.h"
+#include "../State.h"
+#include "../BatchCommandRunner.h"
+#include "../ColumnKernels.h"
+#include "../Instrumentation.h"
+#include "../LittleEndian.h"
+#include "../RegionColumns.h"
+#include "../RegionEpoch.h"
+#include "../RegionJournal.h"
+#include "../RegionNameIndex.h"
+#include "../RegionRollup.h"
+#include "../RegionVisitor.h"
+#include "../StreamingReporter.h"
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <iterator>
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
 
 void RegionTester::testCreateFromStream()
 {
@@ -72,6 +95,301 @@ void RegionTester::testCreateFromStream()
 
 }
 
+void RegionTester::testLoadFromFile()
+{
+    std::cout << "RegionTester::testLoadFromFile" << std::endl;
+
+    // The in-place loader has to build the same hierarchy as loading from a stream
+    for (std::string inputFile : { "SampleData/sampleData-2.txt", "SampleData/sampleData-3.txt", "SampleData/sampleData-4.txt" })
+    {
+        std::ifstream inputStream(inputFile);
+        Region* expected = Region::create(inputStream);
+        Region* world = Region::load(inputFile);
+        if (world==nullptr)
+        {
+            std::cout << "Failed to load a region from " << inputFile << std::endl;
+            return;
+        }
+
+        std::ostringstream expectedText;
+        std::ostringstream actualText;
+        expected->save(expectedText);
+        world->save(actualText);
+        if (actualText.str()!=expectedText.str())
+        {
+            std::cout << "Loading " << inputFile << " in place did not match loading it from a stream" << std::endl;
+            std::cout << "\tExpected:\n" << expectedText.str() << "\tbut got:\n" << actualText.str() << std::endl;
+            return;
+        }
+
+        if (world->computeTotalPopulation()!=expected->computeTotalPopulation())
+        {
+            std::cout << "Failed to compute total population for " << inputFile << std::endl;
+            return;
+        }
+        delete expected;
+        delete world;
+    }
+
+    bool fileFound = true;
+    Region* missing = Region::load("SampleData/no-such-file.txt", &fileFound);
+    if (missing!=nullptr || fileFound)
+    {
+        std::cout << "Loading a missing file did not fail as expected" << std::endl;
+        return;
+    }
+}
+
+void RegionTester::testSnapshot()
+{
+    std::cout << "RegionTester::testSnapshot" << std::endl;
+
+    std::string inputFile = "SampleData/sampleData-4.txt";
+    std::string snapshotFile = "SampleData/snapshot-test.tmp";
+    Region* world = Region::load(inputFile);
+    if (world==nullptr || !world->saveSnapshot(snapshotFile))
+    {
+        std::cout << "Failed to save a snapshot of " << inputFile << std::endl;
+        return;
+    }
+
+    std::ostringstream expectedText;
+    world->save(expectedText);
+    Region* firstNation = world->getSubRegionByIndex(0);
+    unsigned int firstNationId = firstNation->getId();
+    std::string firstNationName = firstNation->getName();
+    delete world;
+
+    Region* restored = Region::loadSnapshot(snapshotFile);
+    if (restored==nullptr)
+    {
+        std::cout << "Failed to load the snapshot of " << inputFile << std::endl;
+        return;
+    }
+
+    std::ostringstream actualText;
+    restored->save(actualText);
+    if (actualText.str()!=expectedText.str())
+    {
+        std::cout << "Snapshot of " << inputFile << " did not restore the same hierarchy" << std::endl;
+        std::cout << "\tExpected:\n" << expectedText.str() << "\tbut got:\n" << actualText.str() << std::endl;
+        return;
+    }
+
+    Region* nation = Region::findById(firstNationId);
+    if (nation==nullptr || nation->getName()!=firstNationName)
+    {
+        std::cout << "Snapshot did not keep the id " << firstNationId << " of " << firstNationName << std::endl;
+        return;
+    }
+    delete restored;
+
+    // A truncated snapshot has to be rejected rather than partly loaded
+    std::string snapshotBytes;
+    {
+        std::ifstream inputStream(snapshotFile, std::ios::binary);
+        snapshotBytes.assign(std::istreambuf_iterator<char>(inputStream), std::istreambuf_iterator<char>());
+    }
+    {
+        std::ofstream outputStream(snapshotFile, std::ios::binary | std::ios::trunc);
+        outputStream.write(snapshotBytes.data(), snapshotBytes.size() - 10);
+    }
+    Region* truncated = Region::loadSnapshot(snapshotFile);
+    if (truncated!=nullptr)
+    {
+        std::cout << "Failed to reject a truncated snapshot" << std::endl;
+        return;
+    }
+
+    // So does one with an id far past any id in use, rather than making room for it in the registry, and the ids it
+    // handed out before it was rejected are given back, even if its next id was higher
+    snapshotBytes.replace(24 + 32, 4, "\xf0\xff\xff\xff", 4);
+    LittleEndian::putU32(&snapshotBytes[8], LittleEndian::getU32(&snapshotBytes[8]) + 1000);
+    {
+        std::ofstream outputStream(snapshotFile, std::ios::binary | std::ios::trunc);
+        outputStream.write(snapshotBytes.data(), snapshotBytes.size());
+    }
+    Region* before = Region::create("5,Before,1,1");
+    Region* corrupt = Region::loadSnapshot(snapshotFile);
+    Region* after = Region::create("5,After,1,1");
+    if (corrupt!=nullptr || after->getId()!=before->getId()+1)
+    {
+        std::cout << "Failed to reject a snapshot with a corrupt id and give back its ids" << std::endl;
+        delete corrupt;
+    }
+    delete before;
+    delete after;
+    std::remove(snapshotFile.c_str());
+}
+
+void RegionTester::testSaveToFile()
+{
+    std::cout << "RegionTester::testSaveToFile" << std::endl;
+
+    std::string inputFile = "SampleData/sampleData-4.txt";
+    std::string outputFile = "SampleData/save-test.tmp";
+    Region* world = Region::load(inputFile);
+    if (world==nullptr)
+    {
+        std::cout << "Failed to load a region from " << inputFile << std::endl;
+        return;
+    }
+
+    std::ostringstream expectedText;
+    world->save(expectedText);
+
+    std::string error;
+    if (!world->save(outputFile, true, &error))
+    {
+        std::cout << "Failed to save to " << outputFile << ": " << error << std::endl;
+        return;
+    }
+
+    std::string actualText;
+    {
+        std::ifstream inputStream(outputFile, std::ios::binary);
+        actualText.assign(std::istreambuf_iterator<char>(inputStream), std::istreambuf_iterator<char>());
+    }
+    std::remove(outputFile.c_str());
+    if (actualText!=expectedText.str())
+    {
+        std::cout << "Saving to " << outputFile << " did not match saving to a stream" << std::endl;
+        std::cout << "\tExpected:\n" << expectedText.str() << "\tbut got:\n" << actualText << std::endl;
+        return;
+    }
+
+    // The text written has to load back into the same hierarchy
+    std::istringstream savedStream(actualText);
+    Region* reloaded = Region::create(savedStream);
+    std::ostringstream reloadedText;
+    if (reloaded!=nullptr)
+        reloaded->save(reloadedText);
+    if (reloadedText.str()!=actualText)
+    {
+        std::cout << "Saved text did not load back into the same hierarchy" << std::endl;
+        return;
+    }
+
+    error = "";
+    if (world->save("SampleData/no-such-directory/save-test.tmp", false, &error) || error.empty())
+    {
+        std::cout << "Failed to report an error saving to a missing directory" << std::endl;
+        return;
+    }
+
+    delete reloaded;
+    delete world;
+}
+
+void RegionTester::testLoadIntoArena()
+{
+    std::cout << "RegionTester::testLoadIntoArena" << std::endl;
+
+    std::string inputFile = "SampleData/sampleData-4.txt";
+    Region* expected = Region::load(inputFile);
+    Region* region = Region::load(inputFile, nullptr, true);
+    if (region==nullptr || region->getType()!=Region::WorldType)
+    {
+        std::cout << "Failed to load a world into an arena from " << inputFile << std::endl;
+        return;
+    }
+
+    World* world = static_cast<World*>(region);
+    if (world->getArena()==nullptr || world->getArena()->getBytesAllocated()==0)
+    {
+        std::cout << "Loading " << inputFile << " did not allocate the regions from the world's arena" << std::endl;
+        return;
+    }
+
+    std::ostringstream expectedText;
+    std::ostringstream actualText;
+    expected->save(expectedText);
+    world->save(actualText);
+    if (actualText.str()!=expectedText.str())
+    {
+        std::cout << "Loading " << inputFile << " into an arena did not build the same hierarchy" << std::endl;
+        return;
+    }
+
+    // Regions from the arena and from the heap can be mixed and deleted the same way
+    Region* nation = world->getSubRegionByIndex(0);
+    nation->addSubregion(Region::create("3,Heap State,10,10"));
+    if (!world->removeSubregion(nation->getId()) || world->getSubRegionCount()!=expected->getSubRegionCount()-1)
+    {
+        std::cout << "Failed to remove a nation from a world loaded into an arena" << std::endl;
+        return;
+    }
+
+    // A nation detached from the arena can outlive the world, and keeps its id and sub-regions
+    Region* detachedNation = world->getSubRegionByIndex(0);
+    unsigned int detachedId = detachedNation->getId();
+    unsigned int detachedPopulation = detachedNation->computeTotalPopulation();
+    int detachedCount = detachedNation->getSubRegionCount();
+    RegionPtr detached = world->detachSubregion(detachedId);
+    delete expected;
+    delete world;
+    if (detached==nullptr || detached->getId()!=detachedId || Region::findById(detachedId)!=detached.get() ||
+        detached->computeTotalPopulation()!=detachedPopulation || detached->getSubRegionCount()!=detachedCount)
+    {
+        std::cout << "Failed to keep a nation detached from an arena after its world was deleted" << std::endl;
+    }
+}
+
+void RegionTester::testParallelLoad()
+{
+    std::cout << "RegionTester::testParallelLoad" << std::endl;
+
+    // The second file has a malformed line inside a nation, which makes the loader fall back to parsing sequentially
+    std::string malformedFile = "SampleData/parallel-test.tmp";
+    {
+        std::ofstream outputStream(malformedFile);
+        outputStream << "1,Big Blue Marble,0,0\n2,Nation A,10,10\n3,State A,20,20\n^^^\n^^^\n"
+                     << "2,Nation B,30,30\n9,Not A Region,1,1\n3,State B,40,40\n^^^\n^^^\n2,Nation C,50,50\n^^^\n";
+    }
+
+    std::string inputFiles[] = { "SampleData/sampleData-3.txt", "SampleData/sampleData-4.txt", malformedFile };
+    for (const std::string& inputFile : inputFiles)
+    {
+        Region* expected = Region::load(inputFile);
+        Region* region = Region::load(inputFile, nullptr, true, 4);
+        if (expected==nullptr || region==nullptr)
+        {
+            std::cout << "Failed to load " << inputFile << " with several threads" << std::endl;
+            return;
+        }
+
+        std::ostringstream expectedText;
+        std::ostringstream actualText;
+        expected->save(expectedText);
+        region->save(actualText);
+        if (actualText.str()!=expectedText.str())
+        {
+            std::cout << "Loading " << inputFile << " with several threads did not build the same hierarchy" << std::endl;
+            std::cout << "\tExpected:\n" << expectedText.str() << "\tbut got:\n" << actualText.str() << std::endl;
+            return;
+        }
+
+        // The ids are handed out in file order, just like a sequential load
+        unsigned int idOffset = region->getId() - expected->getId();
+        for (int i=0; i<region->getSubRegionCount(); i++)
+        {
+            Region* nation = region->getSubRegionByIndex(i);
+            Region* expectedNation = expected->getSubRegionByIndex(i);
+            if (nation->getId()!=expectedNation->getId()+idOffset || Region::findById(nation->getId())!=nation ||
+                nation->getParent()!=region)
+            {
+                std::cout << "Loading " << inputFile << " with several threads gave " << nation->getName()
+                          << " the wrong id or parent" << std::endl;
+                return;
+            }
+        }
+
+        delete expected;
+        delete region;
+    }
+    std::remove(malformedFile.c_str());
+}
+
 void RegionTester::testCreateFromString()
 {
     std::cout << "RegionTester::testCreateFromString" << std::endl;
@@ -462,7 +780,68 @@ void RegionTester::testSubRegions()
     if(region->getSubRegionCount()!=1){
         std::cout<<"Nation didnt have 3 subs, had "<<aNation->getSubRegionCount()<<std::endl;
     }
-    // TODO: Add test cases for managing sub-regions
+
+    // More sub-regions than the old fixed-size array could hold
+    {
+        Region* bigState = Region::create("3,Big State,0,1000");
+        for (int i=0; i<600; i++)
+            bigState->addSubregion(Region::create("4,County " + std::to_string(i) + ",1,1"));
+
+        if (bigState->getSubRegionCount()!=600) {
+            std::cout << "Failed to add 600 counties to a state, had " << bigState->getSubRegionCount() << std::endl;
+            return;
+        }
+        if (bigState->computeTotalPopulation()!=600) {
+            std::cout << "Expected a total population of 600, but got " << bigState->computeTotalPopulation() << std::endl;
+            return;
+        }
+        delete bigState;
+    }
+}
+
+void RegionTester::testLookupById()
+{
+    std::cout << "RegionTester::testLookupById" << std::endl;
+
+    Region* nation = Region::create("2,aNation,900,800");
+    Region* state = Region::create("3,aState,80,70");
+    Region* county = Region::create("4,aCounty,7,6");
+    Region* otherNation = Region::create("2,otherNation,1,1");
+    nation->addSubregion(state);
+    state->addSubregion(county);
+
+    if (Region::findById(county->getId())!=county) {
+        std::cout << "Failed to find county " << county->getId() << " in the registry" << std::endl;
+        return;
+    }
+
+    if (nation->getSubRegionById(state->getId())!=state) {
+        std::cout << "Failed to find state " << state->getId() << " as a sub-region of the nation" << std::endl;
+        return;
+    }
+
+    if (nation->getSubRegionById(county->getId())!=nullptr) {
+        std::cout << "Found county " << county->getId() << " as an immediate sub-region of the nation" << std::endl;
+        return;
+    }
+
+    if (nation->findDescendantById(county->getId())!=county) {
+        std::cout << "Failed to find county " << county->getId() << " as a descendant of the nation" << std::endl;
+        return;
+    }
+
+    if (otherNation->findDescendantById(county->getId())!=nullptr) {
+        std::cout << "Found county " << county->getId() << " as a descendant of the wrong nation" << std::endl;
+        return;
+    }
+
+    unsigned int countyId = county->getId();
+    delete nation;
+    if (Region::findById(countyId)!=nullptr) {
+        std::cout << "Deleted county " << countyId << " is still in the registry" << std::endl;
+        return;
+    }
+    delete otherNation;
 }
 
 void RegionTester::testComputeTotalPopulation()
@@ -486,5 +865,1239 @@ void RegionTester::testComputeTotalPopulation()
     if(county->computeTotalPopulation()!=7){
         std::cout<<"County did not have population of 7, had "<<county->computeTotalPopulation()<<std::endl;
     }
-    // TODO: Add test cases for computeTotalPopulation
+
+    // The cached totals follow changes made below them
+    county->setPopulation(17);
+    if(nation->computeTotalPopulation()!=997){
+        std::cout<<"Nation did not have population of 997 after county update, had "<<nation->computeTotalPopulation()<<std::endl;
+    }
+    Region *city=Region::create("5,aCity,3,1");
+    county->addSubregion(city);
+    if(state->computeTotalPopulation()!=100){
+        std::cout<<"State did not have population of 100 after adding a city, had "<<state->computeTotalPopulation()<<std::endl;
+    }
+    if(!state->removeSubregion(county->getId())){
+        std::cout<<"Failed to remove county from state"<<std::endl;
+    }
+    if(nation->computeTotalPopulation()!=980 || state->getSubRegionCount()!=0){
+        std::cout<<"Nation did not have population of 980 after removing county, had "<<nation->computeTotalPopulation()<<std::endl;
+    }
+    delete nation;
+}
+
+void RegionTester::testRollup()
+{
+    std::cout << "RegionTester::testRollup" << std::endl;
+
+    // A region without an area of its own takes the total area of its sub-regions
+    {
+        Region* nation = Region::create("2,aNation,900,1");
+        nation->setArea(0);
+        Region* state = Region::create("3,aState,80,70");
+        state->addSubregion(Region::create("4,aCounty,7,6"));
+        nation->addSubregion(state);
+        nation->addSubregion(Region::create("3,anotherState,13,30"));
+
+        RegionRollup rollup(*nation, 4);
+        const RegionRollup::Totals& totals = rollup.getTotals(*nation);
+        if (totals.population!=1000 || totals.area!=100 || totals.density!=10)
+        {
+            std::cout << "Nation did not roll up to population=1000, area=100, density=10, had population="
+                      << totals.population << ", area=" << totals.area << ", density=" << totals.density << std::endl;
+        }
+        if (rollup.getTotals(*state).population!=87 || rollup.getTotals(*state).area!=70)
+        {
+            std::cout << "State did not roll up to population=87, area=70" << std::endl;
+        }
+        delete nation;
+    }
+
+    // Rolling up on several threads has to give the same totals as one thread, and the same population as the cache
+    {
+        std::string inputFile = "SampleData/sampleData-4.txt";
+        Region* world = Region::load(inputFile);
+        if (world==nullptr)
+        {
+            std::cout << "Failed to load a region from " << inputFile << std::endl;
+            return;
+        }
+
+        RegionRollup expected(*world, 1);
+        RegionRollup rollup(*world, 4);
+        if (rollup.getTotals(*world).population!=world->computeTotalPopulation())
+        {
+            std::cout << "Rollup of " << inputFile << " did not match the cached total population" << std::endl;
+        }
+
+        std::ostringstream expectedReport;
+        std::ostringstream actualReport;
+        expected.writeReport(expectedReport);
+        rollup.writeReport(actualReport);
+        if (actualReport.str()!=expectedReport.str())
+        {
+            std::cout << "Rollup of " << inputFile << " on several threads did not match the rollup on one thread" << std::endl;
+            std::cout << "\tExpected:\n" << expectedReport.str() << "\tbut got:\n" << actualReport.str() << std::endl;
+        }
+
+        std::ostringstream firstLine;
+        firstLine << world->getId() << ",,World,World," << world->computeTotalPopulation() << ",";
+        if (actualReport.str().compare(0, firstLine.str().size(), firstLine.str())!=0)
+        {
+            std::cout << "Rollup report of " << inputFile << " did not start with " << firstLine.str() << std::endl;
+        }
+
+        // The totals take space for the regions in the hierarchy, and one line comes from the cached totals
+        Region* nation = world->getSubRegionByIndex(0);
+        RegionRollup nationRollup(*nation);
+        if (rollup.getRegionCount()!=13 || nationRollup.getTotals(*world).population!=0)
+        {
+            std::cout << "Rollup of " << inputFile << " had " << rollup.getRegionCount() << " regions, expected 13"
+                      << std::endl;
+        }
+        std::ostringstream oneLine;
+        std::ostringstream allLines;
+        nation->display(oneLine, 0, false);
+        nation->display(allLines, 0, true);
+        if (allLines.str().compare(0, oneLine.str().size(), oneLine.str())!=0)
+        {
+            std::cout << "Displaying one line for a nation gave " << oneLine.str() << "\tbut with its sub-regions "
+                      << allLines.str() << std::endl;
+        }
+        delete world;
+    }
+}
+
+void RegionTester::testNameIndex()
+{
+    std::cout << "RegionTester::testNameIndex" << std::endl;
+
+    std::string inputFile = "SampleData/sampleData-4.txt";
+    Region* world = Region::load(inputFile);
+    if (world==nullptr)
+    {
+        std::cout << "Failed to load a region from " << inputFile << std::endl;
+        return;
+    }
+
+    // A second Logan, in another nation, so that a name can match more than one region
+    Region* england = world->getSubRegionByIndex(2);
+    Region* otherLogan = Region::create("3,LOGAN,10,10");
+    england->addSubregion(otherLogan);
+
+    RegionNameIndex index(*world);
+    if (index.size()!=14)
+    {
+        std::cout << "Name index of " << inputFile << " should have had 14 names, but had " << index.size() << std::endl;
+    }
+
+    std::vector<unsigned int> ids = index.findExact("logan");
+    if (ids.size()!=2 || Region::findById(ids[0])->getName()!="Logan" || ids[1]!=otherLogan->getId())
+    {
+        std::cout << "Failed to find both Logans by exact name, ignoring case" << std::endl;
+    }
+    else if (RegionNameIndex::getPath(ids[0])!="World / United States / Utah / Cache County / Logan" ||
+             RegionNameIndex::getPath(ids[1])!="World / England / LOGAN")
+    {
+        std::cout << "Wrong ancestry for Logan: " << RegionNameIndex::getPath(ids[0]) << " and "
+                  << RegionNameIndex::getPath(ids[1]) << std::endl;
+    }
+
+    ids = index.findPrefix("NORTH");
+    if (ids.size()!=1 || Region::findById(ids[0])->getName()!="North Logan")
+    {
+        std::cout << "Failed to find North Logan by prefix" << std::endl;
+    }
+
+    ids = index.findPrefix("c");
+    if (ids.size()!=2 || Region::findById(ids[0])->getName()!="Cache County" ||
+        Region::findById(ids[1])->getName()!="California")
+    {
+        std::cout << "Failed to find Cache County and California, in name order, by prefix" << std::endl;
+    }
+
+    ids = index.findFuzzy("Deutschland");
+    if (ids.size()!=1 || Region::findById(ids[0])->getName()!="Duetschland")
+    {
+        std::cout << "Failed to find Duetschland by a fuzzy match for Deutschland" << std::endl;
+    }
+
+    ids = index.findFuzzy("Idah", 1);
+    if (ids.size()!=1 || Region::findById(ids[0])->getName()!="Idaho")
+    {
+        std::cout << "Failed to find Idaho by a fuzzy match for Idah" << std::endl;
+    }
+
+    if (!index.findExact("Springfield").empty() || !index.findPrefix("Zz").empty() ||
+        !index.findFuzzy("Springfield").empty())
+    {
+        std::cout << "Found a region that isn't in " << inputFile << std::endl;
+    }
+
+    // A kept index can tell that it is out of date from the change count, which names and shape move but
+    // populations don't
+    std::uint64_t changeCount = Region::getChangeCount();
+    otherLogan->setPopulation(20);
+    if (Region::getChangeCount()!=changeCount)
+    {
+        std::cout << "Changing a population counted as a change to the names or shape" << std::endl;
+    }
+    otherLogan->setName("Logan Again");
+    if (Region::getChangeCount()==changeCount)
+    {
+        std::cout << "Renaming a region didn't count as a change" << std::endl;
+    }
+
+    // Ids of regions removed after the index was built don't resolve to anything
+    unsigned int englandId = england->getId();
+    changeCount = Region::getChangeCount();
+    world->removeSubregion(englandId);
+    if (!RegionNameIndex::getAncestry(englandId).empty() || RegionNameIndex::getPath(englandId)!="" ||
+        Region::getChangeCount()==changeCount)
+    {
+        std::cout << "Removed region still had an ancestry, or didn't count as a change" << std::endl;
+    }
+
+    delete world;
+}
+
+void RegionTester::testColumns()
+{
+    std::cout << "RegionTester::testColumns" << std::endl;
+
+    std::string inputFile = "SampleData/sampleData-4.txt";
+    Region* world = Region::load(inputFile);
+    if (world==nullptr)
+    {
+        std::cout << "Failed to load a region from " << inputFile << std::endl;
+        return;
+    }
+
+    RegionColumns columns(*world);
+    if (columns.size()!=13 || columns.getSubtreeEnds()[0]!=13 || columns.getParents()[0]!=RegionColumns::NO_PARENT)
+    {
+        std::cout << "Columns of " << inputFile << " should have had 13 rows under the world, but had "
+                  << columns.size() << std::endl;
+        return;
+    }
+
+    // Rows are in pre-order, so Logan is the row after Cache County
+    if (columns.getName(3)!="Cache County" || columns.getName(4)!="Logan" || columns.getParents()[4]!=3 ||
+        columns.getSubtreeEnds()[3]!=6 || columns.getTypes()[4]!=Region::CityType ||
+        columns.getIds()[4]!=world->getSubRegionByIndex(0)->getSubRegionByIndex(0)->getSubRegionByIndex(0)
+                ->getSubRegionByIndex(0)->getId())
+    {
+        std::cout << "Columns of " << inputFile << " did not hold Cache County and Logan in pre-order" << std::endl;
+    }
+
+    if (columns.sumPopulation()!=world->computeTotalPopulation() ||
+        columns.computeTotalPopulations()[0]!=world->computeTotalPopulation())
+    {
+        std::cout << "Total population from the columns did not match " << world->computeTotalPopulation() << std::endl;
+    }
+
+    if (columns.sumPopulation(Region::CityType)!=48913+9659)
+    {
+        std::cout << "City population from the columns should have been " << 48913+9659 << ", but was "
+                  << columns.sumPopulation(Region::CityType) << std::endl;
+    }
+
+    std::vector<std::uint32_t> rows = columns.findDenserThan(Region::CityType, 1000);
+    if (rows.size()!=1 || columns.getName(rows[0])!="Logan")
+    {
+        std::cout << "Failed to find Logan as the only city with a density of more than 1000" << std::endl;
+    }
+
+    if (!columns.findDenserThan(Region::NationType, 1e9).empty())
+    {
+        std::cout << "Found a nation with a density of more than 1e9" << std::endl;
+    }
+
+    delete world;
+}
+
+void RegionTester::testColumnKernels()
+{
+    std::cout << "RegionTester::testColumnKernels" << std::endl;
+
+    // Enough rows for full bitmap words and a partial one, with values at the edges of what the kernels handle
+    const std::size_t rowCount = 1000;
+    std::vector<std::uint32_t> populations(rowCount);
+    std::vector<double> areas(rowCount);
+    std::uint32_t seed = 12345;
+    for (std::size_t i=0; i<rowCount; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        populations[i] = (i % 7 == 0) ? UINT32_MAX - (std::uint32_t) i : seed;
+        areas[i] = (i % 11 == 0) ? 0 : (i % 13 == 0) ? std::nan("") : (double) (seed % 100000) / 7;
+    }
+
+    std::vector<double> expectedDensities(rowCount);
+    for (std::size_t i=0; i<rowCount; i++)
+        expectedDensities[i] = (areas[i] > 0) ? (double) populations[i] / areas[i] : 0;
+
+    ColumnKernels::InstructionSet instructionSets[] = { ColumnKernels::Scalar, ColumnKernels::AVX2 };
+    ColumnKernels::InstructionSet original = ColumnKernels::getInstructionSet();
+    for (ColumnKernels::InstructionSet instructionSet : instructionSets)
+    {
+        if (!ColumnKernels::setInstructionSet(instructionSet))
+            continue;
+        std::string label = (instructionSet==ColumnKernels::AVX2) ? "AVX2" : "scalar";
+
+        std::vector<double> densities(rowCount);
+        ColumnKernels::computeDensities(populations.data(), areas.data(), densities.data(), rowCount);
+        if (densities!=expectedDensities)
+        {
+            std::cout << "The " << label << " density kernel did not match dividing one row at a time" << std::endl;
+        }
+
+        std::uint32_t low = 1u << 30;
+        std::uint32_t high = UINT32_MAX - 500;
+        std::vector<std::uint32_t> rows = ColumnKernels::getRows(
+                ColumnKernels::selectRange(populations.data(), rowCount, low, high));
+        std::vector<std::uint32_t> expectedRows;
+        for (std::size_t i=0; i<rowCount; i++)
+        {
+            if (populations[i]>=low && populations[i]<=high)
+                expectedRows.push_back((std::uint32_t) i);
+        }
+        if (rows!=expectedRows)
+        {
+            std::cout << "The " << label << " population range kernel selected " << rows.size()
+                      << " rows, but should have selected " << expectedRows.size() << std::endl;
+        }
+
+        rows = ColumnKernels::getRows(ColumnKernels::selectRange(areas.data(), rowCount, 0.0, 5000.0));
+        expectedRows.clear();
+        for (std::size_t i=0; i<rowCount; i++)
+        {
+            if (areas[i]>=0 && areas[i]<=5000)
+                expectedRows.push_back((std::uint32_t) i);
+        }
+        if (rows!=expectedRows)
+        {
+            std::cout << "The " << label << " area range kernel selected " << rows.size()
+                      << " rows, but should have selected " << expectedRows.size() << std::endl;
+        }
+    }
+    ColumnKernels::setInstructionSet(original);
+
+    std::string inputFile = "SampleData/sampleData-4.txt";
+    Region* world = Region::load(inputFile);
+    if (world==nullptr)
+    {
+        std::cout << "Failed to load a region from " << inputFile << std::endl;
+        return;
+    }
+
+    RegionColumns columns(*world);
+    Region* logan = world->getSubRegionByIndex(0)->getSubRegionByIndex(0)->getSubRegionByIndex(0)
+            ->getSubRegionByIndex(0);
+    std::vector<std::uint32_t> ids = columns.getIds(columns.selectDensity(1000, 2000));
+    if (ids.size()!=1 || ids[0]!=logan->getId())
+    {
+        std::cout << "Failed to find Logan as the only region with a density between 1000 and 2000" << std::endl;
+    }
+
+    ids = columns.getIds(columns.selectPopulation(100000, 300000));
+    if (ids.size()!=2 || Region::findById(ids[0])->getName()!="Cache County" ||
+        Region::findById(ids[1])->getName()!="Davis County")
+    {
+        std::cout << "Failed to find Cache County and Davis County by population" << std::endl;
+    }
+
+    if (columns.getIds(columns.selectArea(5e8, 6e8)).size()!=1)
+    {
+        std::cout << "Failed to find the world as the only region with an area between 5e8 and 6e8" << std::endl;
+    }
+
+    delete world;
+}
+
+void RegionTester::testStreamingReport()
+{
+    std::cout << "RegionTester::testStreamingReport" << std::endl;
+
+    // Blank lines, a line with a bad area, a nation inside a state, and a region left open at the end of the file are
+    // all handled the same way loading the file handles them
+    std::string malformedFile = "SampleData/streaming-test.tmp";
+    {
+        std::ofstream outputStream(malformedFile);
+        outputStream << "1,World,0,1\n2,Nation A,10,10\n\n3,State A,20,abc\n3,State B,30,30\n4,County B,5,2\n"
+                     << "^^^\n2,Nested Nation,1,1\n3,Nested State,1,1\n^^^\n^^^\n"
+                     << "^^^\n^^^\n2,Nation B,40,40\n3,State C,50,50\n";
+    }
+
+    std::string inputFiles[] = { "SampleData/sampleData-1.txt", "SampleData/sampleData-4.txt", malformedFile };
+    for (const std::string& inputFile : inputFiles)
+    {
+        Region* region = Region::load(inputFile);
+        if (region==nullptr)
+        {
+            std::cout << "Failed to load a region from " << inputFile << std::endl;
+            return;
+        }
+
+        std::ostringstream expectedList;
+        region->list(expectedList);
+        std::ostringstream actualList;
+        std::ifstream listStream(inputFile);
+        if (!StreamingReporter::write(listStream, actualList, StreamingReporter::ListReport, region->getId()) ||
+            actualList.str()!=expectedList.str())
+        {
+            std::cout << "Streaming list of " << inputFile << " did not match listing the loaded regions" << std::endl;
+            std::cout << "\tExpected:\n" << expectedList.str() << "\tbut got:\n" << actualList.str() << std::endl;
+        }
+
+        // Display lines come out as each region is closed, so only the lines themselves can be compared
+        std::ostringstream expectedDisplay;
+        region->display(expectedDisplay, 0, true);
+        std::ostringstream actualDisplay;
+        std::ifstream displayStream(inputFile);
+        StreamingReporter::write(displayStream, actualDisplay, StreamingReporter::DisplayReport, region->getId());
+
+        std::vector<std::string> expectedLines;
+        std::vector<std::string> actualLines;
+        std::istringstream expectedLineStream(expectedDisplay.str());
+        std::istringstream actualLineStream(actualDisplay.str());
+        for (std::string line; std::getline(expectedLineStream, line); )
+            expectedLines.push_back(line);
+        for (std::string line; std::getline(actualLineStream, line); )
+            actualLines.push_back(line);
+        std::sort(expectedLines.begin(), expectedLines.end());
+        std::sort(actualLines.begin(), actualLines.end());
+        if (actualLines!=expectedLines)
+        {
+            std::cout << "Streaming display of " << inputFile << " did not match displaying the loaded regions" << std::endl;
+            std::cout << "\tExpected:\n" << expectedDisplay.str() << "\tbut got:\n" << actualDisplay.str() << std::endl;
+        }
+
+        delete region;
+    }
+
+    std::string outputFile = "SampleData/streaming-report.tmp";
+    std::string error;
+    if (StreamingReporter::write("SampleData/no-such-file.txt", outputFile, StreamingReporter::ListReport, 0, &error) ||
+        error.empty())
+    {
+        std::cout << "Streaming report of a missing file did not fail with an error" << std::endl;
+    }
+    if (!StreamingReporter::write(malformedFile, outputFile, StreamingReporter::DisplayReport, 0, &error))
+    {
+        std::cout << "Failed to write a streaming report to " << outputFile << ": " << error << std::endl;
+    }
+
+    std::remove(outputFile.c_str());
+    std::remove(malformedFile.c_str());
+}
+
+void RegionTester::testJournal()
+{
+    std::cout << "RegionTester::testJournal" << std::endl;
+
+    std::string inputFile = "SampleData/sampleData-4.txt";
+    std::string snapshotFile = "SampleData/journal-test.snapshot";
+    std::string journalFile = "SampleData/journal-test.journal";
+    Region* world = Region::load(inputFile);
+    if (world==nullptr)
+    {
+        std::cout << "Failed to load a region from " << inputFile << std::endl;
+        return;
+    }
+
+    // Make some changes, and then "crash" without saving anything but the journal
+    std::string expectedText;
+    unsigned int cityId = 0;
+    {
+        RegionJournal journal(journalFile, snapshotFile, false);
+        journal.open(*world, 0, false);
+        if (!journal.compact() || journal.getGeneration()!=1 || !journal.isOpen())
+        {
+            std::cout << "Failed to start a journal for " << inputFile << ": " << journal.getError() << std::endl;
+            return;
+        }
+
+        Region* nation = world->getSubRegionByIndex(0);
+        Region* state = Region::create("3,Oregon,4000,2500");
+        nation->addSubregion(state);
+        Region* city = Region::create("5,Portland,650000,145");
+        state->addSubregion(city);
+        cityId = city->getId();
+        city->setName("Portland, OR");
+        city->setPopulation(652503);
+        state->setArea(98381);
+        Region* utah = nation->getSubRegionByIndex(0);
+        unsigned int countyId = utah->getSubRegionByIndex(0)->getId();
+        utah->removeSubregion(countyId);
+        Region* movedCounty = utah->getSubRegionByIndex(0);
+        movedCounty->moveTo(*state);
+
+        bool recorded = journal.recordAdd(*state) && journal.recordAdd(*city) && journal.recordName(*city) &&
+                        journal.recordPopulation(*city) && journal.recordArea(*state) &&
+                        journal.recordRemove(*utah, countyId) && journal.recordMove(*movedCounty);
+        if (!recorded)
+        {
+            std::cout << "Failed to record changes in " << journalFile << ": " << journal.getError() << std::endl;
+            return;
+        }
+
+        std::ostringstream text;
+        world->save(text);
+        expectedText = text.str();
+        delete world;
+    }
+
+    // Add a torn record to the end, as if the program stopped in the middle of writing it
+    std::uintmax_t journalSize = 0;
+    {
+        std::ifstream journalStream(journalFile, std::ios::binary | std::ios::ate);
+        journalSize = (std::uintmax_t) journalStream.tellg();
+        std::ofstream tornStream(journalFile, std::ios::binary | std::ios::app);
+        tornStream.write("\x30\x00\x00\x00torn", 8);
+    }
+
+    for (int i=0; i<2; i++)
+    {
+        std::uint32_t generation = 0;
+        Region* reloaded = Region::loadSnapshot(snapshotFile, nullptr, false, &generation);
+        if (reloaded==nullptr || generation!=1)
+        {
+            std::cout << "Failed to load " << snapshotFile << " with generation 1" << std::endl;
+            return;
+        }
+
+        RegionJournal journal(journalFile, snapshotFile, false);
+        std::size_t replayed = journal.open(*reloaded, generation);
+        std::ostringstream text;
+        reloaded->save(text);
+        if (replayed!=7 || text.str()!=expectedText || Region::findById(cityId)==nullptr ||
+            Region::findById(cityId)->getName()!="Portland, OR")
+        {
+            std::cout << "Replaying " << journalFile << " replayed " << replayed << " of 7 changes" << std::endl;
+            std::cout << "\tExpected:\n" << expectedText << "\tbut got:\n" << text.str() << std::endl;
+        }
+        if (journal.getSize()!=journalSize)
+        {
+            std::cout << "Replaying " << journalFile << " did not cut off the torn record" << std::endl;
+        }
+        delete reloaded;
+    }
+
+    // A journal from another generation is left over from a compaction, so it is thrown away
+    {
+        Region* reloaded = Region::loadSnapshot(snapshotFile);
+        RegionJournal journal(journalFile, snapshotFile, false);
+        if (journal.open(*reloaded, 7)!=0 || journal.getSize()!=RegionJournal::HEADER_SIZE)
+        {
+            std::cout << "Replayed a journal from a different generation" << std::endl;
+        }
+        delete reloaded;
+    }
+
+    // Growing past the compaction size writes a new snapshot and starts the journal over
+    {
+        Region* reloaded = Region::loadSnapshot(snapshotFile);
+        RegionJournal journal(journalFile, snapshotFile, false, 64);
+        journal.open(*reloaded, 7);
+        reloaded->setPopulation(1);
+        journal.recordPopulation(*reloaded);
+        reloaded->setName("A world with a name long enough to need compacting");
+        journal.recordName(*reloaded);
+        if (journal.getGeneration()!=8 || journal.getSize()!=RegionJournal::HEADER_SIZE)
+        {
+            std::cout << "Journal was not compacted after growing past its compaction size" << std::endl;
+        }
+        delete reloaded;
+
+        std::uint32_t generation = 0;
+        reloaded = Region::loadSnapshot(snapshotFile, nullptr, false, &generation);
+        if (reloaded==nullptr || generation!=8 || reloaded->getName()!="A world with a name long enough to need compacting")
+        {
+            std::cout << "Compacting the journal did not write the changes to the snapshot" << std::endl;
+        }
+        delete reloaded;
+    }
+
+    std::remove(snapshotFile.c_str());
+    std::remove(journalFile.c_str());
+}
+
+
+void RegionTester::testBatchCommands()
+{
+    std::cout << "RegionTester::testBatchCommands" << std::endl;
+
+    std::string inputFile = "SampleData/sampleData-4.txt";
+    Region* world = Region::load(inputFile);
+    if (world==nullptr)
+    {
+        std::cout << "Failed to load a region from " << inputFile << std::endl;
+        return;
+    }
+
+    Region* nation = world->getSubRegionByIndex(0);
+    Region* utah = nation->getSubRegionByIndex(0);
+    Region* cache = utah->getSubRegionByIndex(0);
+    unsigned int boxElderId = utah->getSubRegionByIndex(1)->getId();
+    int nationCount = world->getSubRegionCount();
+    int utahCount = utah->getSubRegionCount();
+
+    std::ostringstream commands;
+    commands << "# Comments and blank lines are skipped\n"
+             << "\n"
+             << "create " << world->getId() << " 2,Canada,38000000,9984670\n"
+             << "create " << utah->getId() << " 5,Salt Lake City,200000,287\n"
+             << "edit " << cache->getId() << " Cache,,1900\n"
+             << "delete " << boxElderId << "\r\n"
+             << "list " << utah->getId() << "\n"
+             << "print " << cache->getId() << "\n";
+    std::istringstream commandStream(commands.str());
+    std::ostringstream output;
+    BatchCommandRunner runner(*world, output);
+    std::size_t failureCount = runner.run(commandStream);
+
+    std::ostringstream expectedOutput;
+    utah->list(expectedOutput);
+    cache->display(expectedOutput, 0, true);
+    if (failureCount!=0 || runner.getCommandCount()!=6 || output.str()!=expectedOutput.str())
+    {
+        std::cout << "Running good commands failed " << failureCount << " of " << runner.getCommandCount()
+                  << " commands" << std::endl;
+        std::cout << "\tExpected:\n" << expectedOutput.str() << "\tbut got:\n" << output.str() << std::endl;
+    }
+    if (world->getSubRegionCount()!=nationCount+1 || utah->getSubRegionCount()!=utahCount ||
+        Region::findById(boxElderId)!=nullptr)
+    {
+        std::cout << "Running create and delete commands did not add and remove the right regions" << std::endl;
+    }
+    if (cache->getName()!="Cache" || cache->getPopulation()!=116909 || cache->getArea()!=1900)
+    {
+        std::cout << "Running an edit command did not change just the given fields of " << cache->getName() << std::endl;
+    }
+
+    // Every bad command is reported, and none of them stop the rest or change anything
+    std::string badCommands[] = {
+            "frobnicate 1",
+            "print",
+            "print 999999",
+            "print 0 extra",
+            "create " + std::to_string(world->getId()) + " 3,Texas,100,200",
+            "create " + std::to_string(cache->getId()) + " 4,Inner County,100,200",
+            "create " + std::to_string(utah->getId()) + " 4,Bad County,lots,200",
+            "edit " + std::to_string(cache->getId()) + " Cache,-5,1900",
+            "edit " + std::to_string(cache->getId()) + " Cache",
+            "delete " + std::to_string(world->getId())
+    };
+    std::ostringstream badCommandStream;
+    for (const std::string& command : badCommands)
+    {
+        badCommandStream << command << std::endl;
+    }
+    std::ostringstream text;
+    world->save(text);
+    std::string expectedText = text.str();
+
+    output.str("");
+    std::istringstream badCommandInput(badCommandStream.str());
+    std::size_t badCount = sizeof(badCommands) / sizeof(badCommands[0]);
+    failureCount = runner.run(badCommandInput);
+    std::string reportedLines = output.str();
+    if (failureCount!=badCount || runner.getFailureCount()!=badCount ||
+        (std::size_t) std::count(reportedLines.begin(), reportedLines.end(), '\n')!=badCount)
+    {
+        std::cout << "Running bad commands failed " << failureCount << " of " << badCount << " commands" << std::endl;
+        std::cout << reportedLines;
+    }
+
+    text.str("");
+    world->save(text);
+    if (text.str()!=expectedText)
+    {
+        std::cout << "Running bad commands changed the hierarchy" << std::endl;
+    }
+
+    delete world;
+}
+
+void RegionTester::testInstrumentation()
+{
+    std::cout << "RegionTester::testInstrumentation" << std::endl;
+
+    if (!Instrumentation::isEnabled())
+    {
+        std::cout << "Instrumentation is compiled out -- nothing to test" << std::endl;
+        return;
+    }
+
+    Instrumentation::Totals before = Instrumentation::getTotals();
+
+    std::string inputFile = "SampleData/sampleData-4.txt";
+    Region* world = Region::load(inputFile);
+    Region* badRegion = Region::create("4,No Area County,100");
+    Region* unknownRegion = Region::create("9,Nowhere,100,100");
+    Region* found = Region::findById(UINT32_MAX - 1);
+    std::ostringstream text;
+    if (world!=nullptr)
+    {
+        world->save(text);
+    }
+
+    // Regions created on other threads count too, once those threads are done
+    Region* parallelWorld = Region::load(inputFile, nullptr, false, 4);
+
+    Instrumentation::Totals after = Instrumentation::getTotals();
+    std::uint64_t created = after.counters[Instrumentation::RegionsCreated] -
+                            before.counters[Instrumentation::RegionsCreated];
+    std::uint64_t failures = after.counters[Instrumentation::ParseFailures] -
+                             before.counters[Instrumentation::ParseFailures];
+    if (world==nullptr || parallelWorld==nullptr || created!=26)
+    {
+        std::cout << "Loading " << inputFile << " twice counted " << created << " regions created, expected 26"
+                  << std::endl;
+    }
+    if (badRegion!=nullptr || unknownRegion!=nullptr || failures!=2)
+    {
+        std::cout << "Counted " << failures << " parse failures, expected 2" << std::endl;
+    }
+    if (found!=nullptr || after.counters[Instrumentation::IdLookupMisses]==before.counters[Instrumentation::IdLookupMisses])
+    {
+        std::cout << "Looking up an id that doesn't exist was not counted as a miss" << std::endl;
+    }
+    if (after.timers[Instrumentation::LoadTimer].calls!=before.timers[Instrumentation::LoadTimer].calls+2 ||
+        after.timers[Instrumentation::SaveTimer].calls!=before.timers[Instrumentation::SaveTimer].calls+1)
+    {
+        std::cout << "Load and save timers were not called the expected number of times" << std::endl;
+    }
+
+    std::ostringstream report;
+    Instrumentation::write(report);
+    if (report.str().find(Instrumentation::getName(Instrumentation::ParseFailures))==std::string::npos ||
+        report.str().find(Instrumentation::getName(Instrumentation::RollupTimer))==std::string::npos)
+    {
+        std::cout << "The instrumentation report is missing counters or timers:\n" << report.str() << std::endl;
+    }
+
+    delete world;
+    delete parallelWorld;
+}
+
+void RegionTester::testConcurrentReaders()
+{
+    std::cout << "RegionTester::testConcurrentReaders" << std::endl;
+
+    Region* world = Region::create(Region::WorldType, "World", 0, 1);
+    if (world==nullptr)
+    {
+        std::cout << "Failed to create a world" << std::endl;
+        return;
+    }
+    unsigned int worldId = world->getId();
+
+    // Readers display, look up, and roll up the world over and over, while the writer below changes it
+    std::atomic<bool> stop(false);
+    std::atomic<unsigned int> badNames(0);
+    std::atomic<unsigned int> readCount(0);
+    std::vector<std::thread> readers;
+    for (unsigned int i=0; i<4; i++)
+    {
+        readers.emplace_back([world, worldId, &stop, &badNames, &readCount]() {
+            while (!stop.load())
+            {
+                RegionEpoch::ReadGuard guard;
+                std::ostringstream out;
+                world->display(out, 0, true);
+                RegionRollup rollup(*world, 1);
+                for (int j=0; j<world->getSubRegionCount(); j++)
+                {
+                    Region* nation = world->getSubRegionByIndex(j);
+                    if (nation==nullptr)
+                        continue;
+                    const std::string& name = nation->getName();
+                    if (name.compare(0, 7, "Nation ")!=0 && name.compare(0, 8, "Renamed ")!=0)
+                        badNames++;
+                    Region* found = Region::findById(nation->getId());
+                    if (found!=nullptr && found!=nation)
+                        badNames++;
+                    world->findDescendantById(nation->getId() + 1);
+                    rollup.getTotals(*nation);
+                }
+                if (Region::findById(worldId)!=world)
+                    badNames++;
+                readCount++;
+            }
+        });
+    }
+
+    std::vector<unsigned int> nationIds;
+    for (unsigned int i=0; i<300; i++)
+    {
+        Region* nation = Region::create(Region::NationType, "Nation " + std::to_string(i), 100, 10);
+        for (unsigned int j=0; nation!=nullptr && j<3; j++)
+            nation->addSubregion(Region::create(Region::StateType, "State " + std::to_string(j), 10, 1));
+        world->addSubregion(nation);
+        if (nation!=nullptr)
+            nationIds.push_back(nation->getId());
+
+        if (i%3==1)
+        {
+            Region* renamed = world->getSubRegionById(nationIds[i/2]);
+            if (renamed!=nullptr)
+            {
+                renamed->setName("Renamed " + std::to_string(i));
+                renamed->setPopulation(i);
+            }
+        }
+        if (i%3==2)
+            world->removeSubregion(nationIds[i/3]);
+    }
+
+    // Let the readers get a few passes in before stopping them, in case the writer finished first
+    while (readCount.load()<8)
+        std::this_thread::yield();
+    stop = true;
+    for (std::thread& reader : readers)
+        reader.join();
+    RegionEpoch::synchronize();
+
+    if (badNames!=0)
+    {
+        std::cout << "Readers saw " << badNames << " names or lookups that were never written" << std::endl;
+    }
+    if (RegionEpoch::getRetiredCount()!=0)
+    {
+        std::cout << RegionEpoch::getRetiredCount() << " retired objects were not reclaimed" << std::endl;
+    }
+    if (world->getSubRegionCount()!=200)
+    {
+        std::cout << "The world has " << world->getSubRegionCount() << " nations, expected 200" << std::endl;
+    }
+
+    // A reader holds back what is retired while it reads, in batches, and without readers it goes right away
+    {
+        RegionEpoch::ReadGuard guard;
+        for (int i=0; i<100; i++)
+            RegionEpoch::retire(new int(i));
+        if (RegionEpoch::getRetiredCount()!=100)
+        {
+            std::cout << RegionEpoch::getRetiredCount() << " objects were held back by a reader, expected 100"
+                      << std::endl;
+        }
+    }
+    RegionEpoch::synchronize();
+    RegionEpoch::retire(new int(0));
+    if (RegionEpoch::getRetiredCount()!=0)
+    {
+        std::cout << "An object retired with no readers was not reclaimed right away" << std::endl;
+    }
+    RegionRollup rollup(*world, 1);
+    if (rollup.getTotals(*world).population!=world->computeTotalPopulation())
+    {
+        std::cout << "The cached total population " << world->computeTotalPopulation()
+                  << " doesn't match the rollup, " << rollup.getTotals(*world).population << std::endl;
+    }
+    for (unsigned int i=0; i<100; i++)
+    {
+        if (Region::findById(nationIds[i])!=nullptr)
+        {
+            std::cout << "Removed nation " << nationIds[i] << " can still be found by id" << std::endl;
+            break;
+        }
+    }
+
+    delete world;
+}
+
+void RegionTester::testSubtreeRemoval()
+{
+    std::cout << "RegionTester::testSubtreeRemoval" << std::endl;
+
+    Region* nation = Region::create(Region::NationType, "Nation", 1, 1);
+    std::vector<unsigned int> stateIds;
+    std::vector<unsigned int> cityIds;
+    for (unsigned int i=0; i<100; i++)
+    {
+        Region* state = Region::create(Region::StateType, "State " + std::to_string(i), 10, 1);
+        Region* city = Region::create(Region::CityType, "City " + std::to_string(i), 100, 1);
+        state->addSubregion(city);
+        nation->addSubregion(state);
+        stateIds.push_back(state->getId());
+        cityIds.push_back(city->getId());
+    }
+
+    // Removing every state but the multiples of 10, from the back and the front, leaves holes and compacts the list
+    unsigned int kept = 0;
+    for (unsigned int i=0; i<100; i++)
+    {
+        unsigned int index = (i%2==0) ? i/2 : 99 - i/2;
+        if (index%10==0)
+        {
+            kept++;
+        }
+        else if (!nation->removeSubregion(stateIds[index]))
+        {
+            std::cout << "Failed to remove state " << stateIds[index] << std::endl;
+            return;
+        }
+    }
+
+    if (nation->getSubRegionCount()!=(int) kept || nation->computeTotalPopulation()!=1+kept*110)
+    {
+        std::cout << "After removing states, the nation has " << nation->getSubRegionCount() << " states and "
+                  << nation->computeTotalPopulation() << " people, expected " << kept << " and " << 1+kept*110
+                  << std::endl;
+    }
+    for (unsigned int i=0; i<kept; i++)
+    {
+        Region* state = nation->getSubRegionByIndex(i);
+        if (state==nullptr || state->getId()!=stateIds[i*10])
+        {
+            std::cout << "State " << i << " is out of order after removing states" << std::endl;
+            break;
+        }
+    }
+    if (Region::findById(stateIds[1])!=nullptr || Region::findById(cityIds[1])!=nullptr)
+    {
+        std::cout << "A removed state or its city can still be found by id" << std::endl;
+    }
+    if (nation->removeSubregion(stateIds[1]) || nation->removeSubregion(cityIds[0]))
+    {
+        std::cout << "Removed a region that isn't a sub-region of the nation" << std::endl;
+    }
+
+    // Surviving regions can still be removed, and new ones added, once the list has been compacted
+    Region* added = Region::create(Region::StateType, "Added", 5, 1);
+    nation->addSubregion(added);
+    if (!nation->removeSubregion(stateIds[50]) || !nation->removeSubregion(added->getId()) ||
+        nation->getSubRegionCount()!=(int) kept-1 || nation->computeTotalPopulation()!=1+(kept-1)*110)
+    {
+        std::cout << "Failed to remove states after the list was compacted" << std::endl;
+    }
+
+    delete nation;
+}
+
+void RegionTester::testRegionHandles()
+{
+    std::cout << "RegionTester::testRegionHandles" << std::endl;
+
+    std::string inputFile = "SampleData/sampleData-4.txt";
+    RegionPtr loaded(Region::load(inputFile, nullptr, true));
+    RegionPtr imported(Region::load(inputFile, nullptr, true));
+    if (loaded==nullptr || imported==nullptr || loaded->getType()!=Region::WorldType)
+    {
+        std::cout << "Failed to load " << inputFile << std::endl;
+        return;
+    }
+    World* world = static_cast<World*>(loaded.get());
+    unsigned int worldPopulation = world->computeTotalPopulation();
+
+    // A detached state keeps its id and sub-regions and can be added to another nation.  It was loaded into the
+    // world's arena, so the handle holds a copy of it on the heap.
+    Region* from = world->getSubRegionByIndex(0);
+    Region* to = world->getSubRegionByIndex(1);
+    Region* state = (from!=nullptr) ? from->getSubRegionByIndex(0) : nullptr;
+    if (to==nullptr || state==nullptr)
+    {
+        std::cout << inputFile << " doesn't have two nations with states" << std::endl;
+        return;
+    }
+    unsigned int statePopulation = state->computeTotalPopulation();
+    unsigned int fromPopulation = from->computeTotalPopulation();
+    unsigned int toPopulation = to->computeTotalPopulation();
+    int stateSubRegionCount = state->getSubRegionCount();
+
+    unsigned int stateId = state->getId();
+    RegionPtr detached = from->detachSubregion(stateId);
+    state = detached.get();
+    if (state==nullptr || state->getId()!=stateId || state->getParent()!=nullptr ||
+        Region::findById(stateId)!=state || state->computeTotalPopulation()!=statePopulation ||
+        world->computeTotalPopulation()!=worldPopulation-statePopulation)
+    {
+        std::cout << "Detaching a state didn't unlink it and take out its population" << std::endl;
+        return;
+    }
+    if (from->detachSubregion(state->getId())!=nullptr)
+    {
+        std::cout << "Detached a state that was already detached" << std::endl;
+    }
+
+    to->addSubregion(std::move(detached));
+    if (detached!=nullptr || state->getParent()!=to || state->getSubRegionCount()!=stateSubRegionCount ||
+        from->computeTotalPopulation()!=fromPopulation-statePopulation ||
+        to->computeTotalPopulation()!=toPopulation+statePopulation ||
+        world->computeTotalPopulation()!=worldPopulation ||
+        world->findDescendantById(state->getId())!=state)
+    {
+        std::cout << "Moving a state to another nation didn't keep its subtree and totals" << std::endl;
+    }
+
+    // Letting go of a handle deletes the subtree
+    Region* city = Region::create("5,Handled,100,10");
+    unsigned int cityId = city->getId();
+    {
+        RegionPtr handle(city);
+    }
+    if (Region::findById(cityId)!=nullptr)
+    {
+        std::cout << "A region let go of by its handle can still be found by id" << std::endl;
+    }
+
+    // Merging a whole world moves its nations, and the arena they live in, without copying
+    int nationCount = world->getSubRegionCount() + imported->getSubRegionCount();
+    unsigned int importedPopulation = imported->computeTotalPopulation();
+    Region* importedNation = imported->getSubRegionByIndex(0);
+    if (!world->mergeWorld(static_cast<World&>(*imported)) || world->getSubRegionCount()!=nationCount ||
+        imported->getSubRegionCount()!=0 || imported->computeTotalPopulation()!=imported->getPopulation() ||
+        world->computeTotalPopulation()!=worldPopulation+importedPopulation ||
+        importedNation==nullptr || importedNation->getParent()!=world)
+    {
+        std::cout << "Merging an imported world didn't move all of its nations" << std::endl;
+    }
+    imported.reset();
+    std::ostringstream text;
+    world->save(text);
+
+    if (world->mergeSubregions(*world) || to->mergeSubregions(*world))
+    {
+        std::cout << "Merged a region into itself or one of its descendants" << std::endl;
+    }
+}
+
+void RegionTester::testRelocate()
+{
+    std::cout << "RegionTester::testRelocate" << std::endl;
+
+    std::string inputFile = "SampleData/sampleData-4.txt";
+    Region* world = Region::load(inputFile);
+    Region* otherWorld = Region::load(inputFile);
+    if (world==nullptr || otherWorld==nullptr)
+    {
+        std::cout << "Failed to load a region from " << inputFile << std::endl;
+        return;
+    }
+
+    Region* nation = world->getSubRegionByIndex(0);
+    Region* utah = nation->getSubRegionByIndex(0);
+    Region* california = nation->getSubRegionByIndex(1);
+    Region* cache = utah->getSubRegionByIndex(0);
+    Region* logan = cache->getSubRegionByIndex(0);
+    unsigned int worldPopulation = world->computeTotalPopulation();
+    unsigned int utahPopulation = utah->computeTotalPopulation();
+    unsigned int californiaPopulation = california->computeTotalPopulation();
+    unsigned int cachePopulation = cache->computeTotalPopulation();
+
+    // A county moves with its cities, and only the totals between the two states change
+    if (!cache->moveTo(*california) || cache->getParent()!=california || utah->getSubRegionById(cache->getId())!=nullptr ||
+        california->getSubRegionById(cache->getId())!=cache || logan->getParent()!=cache ||
+        utah->computeTotalPopulation()!=utahPopulation-cachePopulation ||
+        california->computeTotalPopulation()!=californiaPopulation+cachePopulation ||
+        world->computeTotalPopulation()!=worldPopulation)
+    {
+        std::cout << "Failed to move Cache County to California" << std::endl;
+    }
+
+    // A city can go under a state or a county, but nothing can go under itself, a type that can't contain it, or
+    // another hierarchy
+    if (!logan->moveTo(*utah) || logan->getParent()!=utah || cache->getSubRegionCount()!=1)
+    {
+        std::cout << "Failed to move Logan from Cache County to Utah" << std::endl;
+    }
+    Region* otherUtah = otherWorld->getSubRegionByIndex(0)->getSubRegionByIndex(0);
+    if (cache->moveTo(*nation) || california->moveTo(*cache) || nation->moveTo(*california) ||
+        world->moveTo(*nation) || cache->moveTo(*otherUtah) || utah->moveTo(*utah))
+    {
+        std::cout << "Moved a region somewhere it can't go" << std::endl;
+    }
+    Region::MoveFailure topFailure;
+    Region::MoveFailure typeFailure;
+    Region::MoveFailure hierarchyFailure;
+    world->moveTo(*nation, &topFailure);
+    cache->moveTo(*nation, &typeFailure);
+    cache->moveTo(*otherUtah, &hierarchyFailure);
+    if (topFailure!=Region::MoveFromTop || typeFailure!=Region::MoveToWrongType ||
+        hierarchyFailure!=Region::MoveToOtherHierarchy ||
+        cache->describeMoveFailure(typeFailure, *nation)!="A Nation can't contain a County")
+    {
+        std::cout << "Failed to say why a region couldn't be moved" << std::endl;
+    }
+    if (world->computeTotalPopulation()!=worldPopulation || otherWorld->computeTotalPopulation()!=worldPopulation)
+    {
+        std::cout << "Moving regions changed the total population of the world" << std::endl;
+    }
+
+    // The batch move command does the same, and says why when it can't
+    std::ostringstream commands;
+    commands << "move " << cache->getId() << " " << utah->getId() << "\n"
+             << "move " << cache->getId() << " " << nation->getId() << "\n"
+             << "move " << world->getId() << " " << nation->getId() << "\n";
+    std::istringstream commandStream(commands.str());
+    std::ostringstream output;
+    BatchCommandRunner runner(*world, output);
+    if (runner.run(commandStream)!=2 || cache->getParent()!=utah ||
+        output.str().find("A Nation can't contain a County")==std::string::npos)
+    {
+        std::cout << "The batch move command didn't move Cache County back to Utah:\n" << output.str() << std::endl;
+    }
+
+    delete world;
+    delete otherWorld;
+}
+
+void RegionTester::testHierarchyRules()
+{
+    std::cout << "RegionTester::testHierarchyRules" << std::endl;
+
+    static_assert(Region::canContain<State, County>() && !Region::canContain<City, County>(),
+                  "The hierarchy rules are checked at compile time");
+
+    if (!Region::canContain(Region::StateType, Region::CityType) ||
+        Region::canContain(Region::NationType, Region::CityType) ||
+        Region::canContain(Region::CityType, Region::CityType) ||
+        Region::canContain((Region::RegionType) 9, Region::CityType) ||
+        Region::canContain(Region::WorldType, (Region::RegionType) 9))
+    {
+        std::cout << "The hierarchy rules don't match the menus" << std::endl;
+    }
+
+    // A region that can't go where it is added is disposed of
+    Region* nation = Region::create("2,Nation,100,100");
+    Region* city = Region::create("5,Misplaced,10,10");
+    unsigned int cityId = city->getId();
+    if (nation->addSubregion(city) || nation->getSubRegionCount()!=0 || nation->computeTotalPopulation()!=100 ||
+        Region::findById(cityId)!=nullptr)
+    {
+        std::cout << "Added a city directly to a nation" << std::endl;
+    }
+    if (!nation->addSubregion(RegionPtr(Region::create("3,State,10,10"))) || nation->getSubRegionCount()!=1)
+    {
+        std::cout << "Failed to add a state to a nation" << std::endl;
+    }
+
+    // Nor can a merge put a state's counties and cities straight into a nation
+    Region* state = Region::create("3,Merged State,10,10");
+    state->addSubregion(Region::create("4,County,10,10"));
+    state->addSubregion(Region::create("5,City,10,10"));
+    if (nation->mergeSubregions(*state) || state->getSubRegionCount()!=2 || nation->getSubRegionCount()!=1 ||
+        nation->computeTotalPopulation()!=110)
+    {
+        std::cout << "Merged a state's counties and cities into a nation" << std::endl;
+    }
+    delete state;
+    delete nation;
+
+    // A nation inside a state is skipped along with its sub-regions, and the regions after it are still loaded
+    std::string inputFile = "SampleData/hierarchy-test.tmp";
+    {
+        std::ofstream outputStream(inputFile);
+        outputStream << "1,World,0,1\n2,Nation A,10,10\n3,State A,20,20\n2,Nested Nation,1,1\n3,Nested State,1,1\n"
+                     << "^^^\n^^^\n5,City A,30,3\n^^^\n^^^\n^^^\n3,State At The Top,1,1\n4,County At The Top,1,1\n^^^\n"
+                     << "^^^\n2,Nation B,40,40\n^^^\n^^^\n";
+    }
+    Region* world = Region::load(inputFile);
+    Region* parallelWorld = Region::load(inputFile, nullptr, false, 4);
+    std::ifstream inputStream(inputFile);
+    Region* streamedWorld = Region::create(inputStream);
+    if (world==nullptr || parallelWorld==nullptr || streamedWorld==nullptr)
+    {
+        std::cout << "Failed to load a region from " << inputFile << std::endl;
+        return;
+    }
+
+    Region* stateA = world->getSubRegionByIndex(0)->getSubRegionByIndex(0);
+    if (world->getSubRegionCount()!=2 || stateA==nullptr || stateA->getSubRegionCount()!=1 ||
+        stateA->getSubRegionByIndex(0)->getName()!="City A" || world->computeTotalPopulation()!=100)
+    {
+        std::ostringstream text;
+        world->save(text);
+        std::cout << "Misplaced regions in " << inputFile << " were not skipped:\n" << text.str() << std::endl;
+    }
+
+    std::ostringstream expectedText;
+    std::ostringstream parallelText;
+    std::ostringstream streamedText;
+    world->save(expectedText);
+    parallelWorld->save(parallelText);
+    streamedWorld->save(streamedText);
+    if (parallelText.str()!=expectedText.str() || streamedText.str()!=expectedText.str())
+    {
+        std::cout << "Loading " << inputFile << " in parallel or from a stream skipped different regions" << std::endl;
+    }
+
+    // The batch create command reports a region it couldn't add, and records nothing in the journal
+    std::string journalFile = "SampleData/hierarchy-test.journal.tmp";
+    std::string snapshotFile = "SampleData/hierarchy-test.snapshot.tmp";
+    {
+        RegionJournal journal(journalFile, snapshotFile, false);
+        journal.open(*world, 0, false);
+        std::istringstream commandStream("create " + std::to_string(world->getId()) + " 5,Misplaced City,1,1\n");
+        std::ostringstream output;
+        BatchCommandRunner runner(*world, output, &journal);
+        if (runner.run(commandStream)!=1 || world->getSubRegionCount()!=2 ||
+            journal.getSize()!=RegionJournal::HEADER_SIZE ||
+            output.str().find("A World can't contain a City")==std::string::npos)
+        {
+            std::cout << "The batch create command didn't refuse a city in the world:\n" << output.str() << std::endl;
+        }
+    }
+    std::remove(journalFile.c_str());
+    std::remove(snapshotFile.c_str());
+
+    delete world;
+    delete parallelWorld;
+    delete streamedWorld;
+    std::remove(inputFile.c_str());
+}
+
+// Counts the regions and the deepest level reached, skipping the sub-regions of regions at the depth limit
+struct RegionCounter : RegionVisitor<RegionCounter> {
+    unsigned int    depthLimit;
+    unsigned int    entered = 0;
+    unsigned int    left = 0;
+    unsigned int    maxDepth = 0;
+
+    explicit RegionCounter(unsigned int depthLimit) : depthLimit(depthLimit) {}
+
+    bool enter(const Region&, unsigned int depth)
+    {
+        entered++;
+        maxDepth = std::max(maxDepth, depth);
+        return depth < depthLimit;
+    }
+
+    void leave(const Region&, unsigned int) { left++; }
+};
+
+void RegionTester::testRegionVisitor()
+{
+    std::cout << "RegionTester::testRegionVisitor" << std::endl;
+
+    if (Region::regionLabelView(Region::CityType)!="City" || Region::regionLabelView((Region::RegionType) 9)!="Unknown")
+    {
+        std::cout << "The region labels don't match the region types" << std::endl;
+    }
+
+    Region* world = Region::load("SampleData/sampleData-4.txt");
+    if (world==nullptr)
+    {
+        std::cout << "Failed to load SampleData/sampleData-4.txt" << std::endl;
+        return;
+    }
+
+    RegionCounter counter(10);
+    counter.visit(*world);
+    if (counter.entered!=13 || counter.left!=13 || counter.maxDepth!=4)
+    {
+        std::cout << "Visited " << counter.entered << " regions down to depth " << counter.maxDepth
+                  << ", expected 13 down to depth 4" << std::endl;
+    }
+
+    RegionCounter prunedCounter(1);
+    prunedCounter.visit(*world);
+    if (prunedCounter.entered!=1 + (unsigned int) world->getSubRegionCount() ||
+        prunedCounter.left!=prunedCounter.entered || prunedCounter.maxDepth!=1)
+    {
+        std::cout << "Visited " << prunedCounter.entered << " regions when the walk stopped below the nations"
+                  << std::endl;
+    }
+
+    delete world;
 }
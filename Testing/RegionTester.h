@@ -9,11 +9,31 @@ class RegionTester
 {
 public:
     void testCreateFromStream();
+    void testLoadFromFile();
+    void testSnapshot();
+    void testSaveToFile();
+    void testLoadIntoArena();
+    void testParallelLoad();
     void testCreateFromString();
     void testCreateFromTypeAndString();
     void testGettersAndSetters();
     void testSubRegions();
+    void testLookupById();
     void testComputeTotalPopulation();
+    void testRollup();
+    void testNameIndex();
+    void testColumns();
+    void testColumnKernels();
+    void testStreamingReport();
+    void testJournal();
+    void testBatchCommands();
+    void testInstrumentation();
+    void testConcurrentReaders();
+    void testSubtreeRemoval();
+    void testRegionHandles();
+    void testRelocate();
+    void testHierarchyRules();
+    void testRegionVisitor();
 };
 
 
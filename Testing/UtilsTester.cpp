@@ -6,6 +6,7 @@
 
 #include <iostream>
 #include <cmath>
+#include <climits>
 
 #include "../Utils.h"
 
@@ -647,3 +648,102 @@ void UtilsTester::testTrim()
 
 }
 
+
+void UtilsTester::testSplitView()
+{
+    std::cout << "Execute UtilsTester::testSplitView" << std::endl;
+
+    std::string_view pieces[3];
+    std::string lineToSplit = " ABC , DEF,GHI ";
+    if (!split(std::string_view(lineToSplit), ',', pieces, 3) ||
+        pieces[0] != "ABC" || pieces[1] != "DEF" || pieces[2] != "GHI") {
+        std::cout << "Failure in split(view, ',', pieces, 3) for lineToSplit=\""
+                  << lineToSplit << "\": pieces not as expected" << std::endl;
+        return;
+    }
+
+    if (pieces[0].data() != lineToSplit.data() + 1) {
+        std::cout << "Failure in split(view, ',', pieces, 3) for lineToSplit=\""
+                  << lineToSplit << "\": pieces do not point into the original string" << std::endl;
+        return;
+    }
+
+    lineToSplit = "MNO,,STU";
+    if (!split(std::string_view(lineToSplit), ',', pieces, 3) || pieces[1] != "") {
+        std::cout << "Failure in split(view, ',', pieces, 3) for lineToSplit=\""
+                  << lineToSplit << "\": pieces not as expected" << std::endl;
+        return;
+    }
+
+    lineToSplit = "MNO,PQR,";
+    if (split(std::string_view(lineToSplit), ',', pieces, 3)) {
+        std::cout << "Failure in split(view, ',', pieces, 3) for lineToSplit=\""
+                  << lineToSplit << "\": result value not as expected" << std::endl;
+        return;
+    }
+}
+
+void UtilsTester::testParseNumbers()
+{
+    std::cout << "Execute UtilsTester::testParseNumbers" << std::endl;
+
+    // The view-based parsers accept exactly what the std::stoi/stoul/stod based conversions did
+    struct IntCase { const char* s; bool isValid; int result; };
+    const IntCase intCases[] = { {"123", true, 123}, {"   1234567  ", true, 1234567}, {"  -123", true, -123},
+                                 {"+42", true, 42}, {"- 123", false, 0}, {"123.45", false, 0}, {"1237A", false, 0},
+                                 {"2147483647", true, 2147483647}, {"-2147483648", true, INT_MIN},
+                                 {"2147483648", false, 0}, {"12372355225233333223", false, 0}, {"", false, 0} };
+    for (const IntCase& c : intCases) {
+        bool isValid;
+        int result = parseInt(c.s, &isValid);
+        if (result != c.result || isValid != c.isValid) {
+            std::cout << "Failure in parseInt(s, &isValid) for s=\"" << c.s
+                      << "\" result=" << result << " isValid=" << isValid << std::endl;
+            return;
+        }
+    }
+
+    struct UnsignedCase { const char* s; bool isValid; unsigned int result; };
+    const UnsignedCase unsignedCases[] = { {"123", true, 123}, {" +7 ", true, 7}, {"-0", false, 0}, {"-123", false, 0},
+                                           {"4294967295", true, 4294967295u}, {"4294967296", false, 0},
+                                           {"1 2", false, 0}, {"   ", false, 0} };
+    for (const UnsignedCase& c : unsignedCases) {
+        bool isValid;
+        unsigned int result = parseUnsignedInt(c.s, &isValid);
+        if (result != c.result || isValid != c.isValid) {
+            std::cout << "Failure in parseUnsignedInt(s, &isValid) for s=\"" << c.s
+                      << "\" result=" << result << " isValid=" << isValid << std::endl;
+            return;
+        }
+    }
+
+    struct DoubleCase { const char* s; bool isValid; double result; };
+    const DoubleCase doubleCases[] = { {"123.4567", true, 123.4567}, {" 5.101e+008 ", true, 5.101e8}, {".5", true, 0.5},
+                                       {"-12", true, -12}, {"1.2.3", false, 0}, {"1e400", false, 0}, {"e5", false, 0},
+                                       {"", false, 0} };
+    for (const DoubleCase& c : doubleCases) {
+        bool isValid;
+        double result = parseDouble(c.s, &isValid);
+        if (result != c.result || isValid != c.isValid) {
+            std::cout << "Failure in parseDouble(s, &isValid) for s=\"" << c.s
+                      << "\" result=" << result << " isValid=" << isValid << std::endl;
+            return;
+        }
+    }
+}
+
+void UtilsTester::testTrimInPlace()
+{
+    std::cout << "Execute UtilsTester::testTrimInPlace" << std::endl;
+
+    const std::string inputs[] = { "ABC", "  ABC", "ABC  ", " \t A B C \n", "", "      \t\t\n\t    " };
+    for (const std::string& s : inputs) {
+        std::string result = s;
+        trimInPlace(result);
+        if (result != trim(s) || trimView(s) != trim(s)) {
+            std::cout << "Failure in trimInPlace(s) for s=\"" << s
+                      << "\" result=" << result << std::endl;
+            return;
+        }
+    }
+}
@@ -17,6 +17,10 @@ public:
     void testLeftTrim();
     void testRightTrim();
     void testTrim();
+
+    void testSplitView();
+    void testParseNumbers();
+    void testTrimInPlace();
 };
 
 
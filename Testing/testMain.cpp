@@ -19,14 +19,37 @@ int main() {
     utilsTester.testLeftTrim();
     utilsTester.testRightTrim();
     utilsTester.testTrim();
+    utilsTester.testSplitView();
+    utilsTester.testParseNumbers();
+    utilsTester.testTrimInPlace();
 
     RegionTester regionTester;
     regionTester.testCreateFromStream();
+    regionTester.testLoadFromFile();
+    regionTester.testSnapshot();
+    regionTester.testSaveToFile();
+    regionTester.testLoadIntoArena();
+    regionTester.testParallelLoad();
     regionTester.testCreateFromString();
     regionTester.testCreateFromTypeAndString();
     regionTester.testGettersAndSetters();
     regionTester.testSubRegions();
+    regionTester.testLookupById();
     regionTester.testComputeTotalPopulation();
+    regionTester.testRollup();
+    regionTester.testNameIndex();
+    regionTester.testColumns();
+    regionTester.testColumnKernels();
+    regionTester.testStreamingReport();
+    regionTester.testJournal();
+    regionTester.testBatchCommands();
+    regionTester.testInstrumentation();
+    regionTester.testConcurrentReaders();
+    regionTester.testSubtreeRemoval();
+    regionTester.testRegionHandles();
+    regionTester.testRelocate();
+    regionTester.testHierarchyRules();
+    regionTester.testRegionVisitor();
     //regionTester.testList();
     //regionTester.testDisplay();
     //regionTester.testSave();
@@ -6,12 +6,18 @@
 #include "NationUserInterface.h"
 #include "StateUserInterface.h"
 #include "CountyUserInterface.h"
+#include "Instrumentation.h"
 #include "Menu.h"
+#include "RegionJournal.h"
+#include "RegionNameIndex.h"
+#include "RegionRollup.h"
 #include "Utils.h"
 
+#include <iomanip>
 #include <iostream>
 
-UserInterface::UserInterface(Region* contextRegion) : m_currentRegion(contextRegion)
+UserInterface::UserInterface(Region* contextRegion, RegionJournal* journal) :
+        m_currentRegion(contextRegion), m_journal(journal)
 {
 }
 
@@ -68,10 +74,26 @@ void UserInterface::run()
         {
             remove();
         }
+        else if (command=="R")
+        {
+            relocate();
+        }
         else if (command=="P")
         {
             print();
         }
+        else if (command=="T")
+        {
+            writeRollupReport();
+        }
+        else if (command=="F")
+        {
+            find();
+        }
+        else if (command=="I")
+        {
+            showInstrumentation();
+        }
         else if (command=="M")
         {
             changeToSubRegion();
@@ -87,15 +109,27 @@ void UserInterface::add()
 {
     m_subRegionType = getSubRegionType();
 
-    if (m_subRegionType!=Region::RegionType::UnknownRegionType) {
+    if (m_subRegionType!=Region::RegionType::UnknownRegionType &&
+        !Region::canContain(m_currentRegion->getType(), m_subRegionType)) {
+        std::cout << "A " << m_currentRegion->getRegionLabel() << " can't contain a "
+                  << Region::regionLabel(m_subRegionType) << std::endl;
+    }
+    else if (m_subRegionType!=Region::RegionType::UnknownRegionType) {
         std::string data = getStringInput(
                 "Enter name,population,areas for " + Region::regionLabel(m_subRegionType) + ":");
         if (data != "") {
-            Region *region = Region::create(m_subRegionType, data);
+            RegionPtr region(Region::create(m_subRegionType, data));
             if (region != nullptr) {
                 // DONE: Add region to the m_currentRegion
-                m_currentRegion->addSubregion(region);
-                std::cout << Region::regionLabel(m_subRegionType) << " added" << std::endl;
+                Region& added = *region;
+                if (!m_currentRegion->addSubregion(std::move(region))) {
+                    std::cout << "A " << m_currentRegion->getRegionLabel() << " can't contain a "
+                              << Region::regionLabel(m_subRegionType) << " - no region added" << std::endl;
+                } else {
+                    if (m_journal != nullptr)
+                        checkJournal(m_journal->recordAdd(added));
+                    std::cout << Region::regionLabel(m_subRegionType) << " added" << std::endl;
+                }
             } else {
                 std::cout << "Invalid data - no region created" << std::endl;
             }
@@ -123,7 +157,7 @@ void UserInterface::edit()
         if (valid && id>0)
         {
             Region* region;
-            region=m_currentRegion->getSubRegionByIndex(id);
+            region=m_currentRegion->getSubRegionById(id);
             // DONE: Look the region by Id and assign it to region variable
             if (region!=nullptr)
             {
@@ -134,6 +168,10 @@ void UserInterface::edit()
                 editArea(region);
 
             }
+            else
+            {
+                std::cout << "No region with that id -- nothing selected for edit" << std::endl;
+            }
         }
         else
         {
@@ -153,6 +191,8 @@ void UserInterface::editName(Region* region)
     if (updatedName!="")
     {
         region->setName(updatedName);
+        if (m_journal != nullptr)
+            checkJournal(m_journal->recordName(*region));
         std::cout << "Name updated" << std::endl;
     }
     else
@@ -171,6 +211,8 @@ void UserInterface::editPopulation(Region* region)
         if (valid)
         {
             region->setPopulation(newPopulation);
+            if (m_journal != nullptr)
+                checkJournal(m_journal->recordPopulation(*region));
             std::cout << "Population updated" << std::endl;
         }
         else
@@ -195,6 +237,8 @@ void UserInterface::editArea(Region* region)
         if (valid)
         {
             region->setArea(newArea);
+            if (m_journal != nullptr)
+                checkJournal(m_journal->recordArea(*region));
             std::cout << "Area updated" << std::endl;
         }
         else
@@ -218,10 +262,14 @@ void UserInterface::remove()
         unsigned int id = convertStringToUnsignedInt(input, &valid);
         if (valid && id>0)
         {
-            //that looks like a typo
-            // DONE: Look up the region by Id and assign it to the region variable
-            delete m_currentRegion->getSubRegionByIndex(id);
-            std::cout << "Deleted!" << std::endl;
+            if (m_currentRegion->removeSubregion(id))
+            {
+                if (m_journal != nullptr)
+                    checkJournal(m_journal->recordRemove(*m_currentRegion, id));
+                std::cout << "Deleted!" << std::endl;
+            }
+            else
+                std::cout << "No region with that id -- nothing deleted" << std::endl;
         }
         else
         {
@@ -234,11 +282,115 @@ void UserInterface::remove()
     }
 }
 
+// Moves a sub-region of the current context, along with all of its sub-regions, under another region of the
+// hierarchy, given by its id
+void UserInterface::relocate()
+{
+    std::string input = getStringInput("Which region would you like to relocate? Enter the id:");
+    if (input=="")
+    {
+        std::cout << "No id entered - nothing relocated" << std::endl;
+        return;
+    }
+
+    bool valid;
+    unsigned int id = convertStringToUnsignedInt(input, &valid);
+    Region* region = valid ? m_currentRegion->getSubRegionById(id) : nullptr;
+    if (region==nullptr)
+    {
+        std::cout << "No region with that id -- nothing relocated" << std::endl;
+        return;
+    }
+
+    input = getStringInput("Enter the id of the region to move it to:");
+    unsigned int newParentId = convertStringToUnsignedInt(input, &valid);
+    Region* newParent = valid ? Region::findById(newParentId) : nullptr;
+    Region::MoveFailure failure;
+    if (newParent==nullptr)
+    {
+        std::cout << "No region with that id -- nothing relocated" << std::endl;
+    }
+    else if (region->moveTo(*newParent, &failure))
+    {
+        if (m_journal != nullptr)
+            checkJournal(m_journal->recordMove(*region));
+        std::cout << "Relocated!" << std::endl;
+    }
+    else
+    {
+        std::cout << region->describeMoveFailure(failure, *newParent) << " -- nothing relocated" << std::endl;
+    }
+}
+
 void UserInterface::print()
 {
     m_currentRegion->display(std::cout, 0, true);
 };
 
+void UserInterface::writeRollupReport()
+{
+    std::string filename = getStringInput("Enter the name of the report file:");
+    if (filename!="")
+    {
+        std::string error;
+        RegionRollup rollup(*m_currentRegion);
+        if (rollup.writeReport(filename, &error))
+            std::cout << "Report written to " << filename << std::endl;
+        else
+            std::cout << "Problem writing " << filename << " -- " << error << std::endl;
+    }
+    else
+    {
+        std::cout << "No file name entered - no report written" << std::endl;
+    }
+}
+
+// Shows how many times the instrumented operations have run since the program started, and how long they took
+void UserInterface::showInstrumentation()
+{
+    Instrumentation::write(std::cout);
+}
+
+// Looks for regions with the name anywhere below the current region.  If there aren't any, it looks for names that
+// start with what was entered, and then for names that are spelled almost the same.  The index is kept between
+// finds, and only rebuilt once a region has been renamed, added, removed, or moved.
+void UserInterface::find()
+{
+    std::string name = getStringInput("Enter the name, or the start of the name, to find:");
+    if (name!="")
+    {
+        std::uint64_t changeCount = Region::getChangeCount();
+        if (m_nameIndex==nullptr || m_nameIndexChangeCount!=changeCount)
+        {
+            m_nameIndex.reset(new RegionNameIndex(*m_currentRegion));
+            m_nameIndexChangeCount = changeCount;
+        }
+
+        const RegionNameIndex& index = *m_nameIndex;
+        std::vector<unsigned int> ids = index.findExact(name);
+        if (ids.empty())
+            ids = index.findPrefix(name);
+        if (ids.empty())
+            ids = index.findFuzzy(name);
+
+        for (unsigned int id : ids)
+            std::cout << std::setw(6) << id << "  " << RegionNameIndex::getPath(id) << std::endl;
+        if (ids.empty())
+            std::cout << "No region with a name like " << name << std::endl;
+    }
+    else
+    {
+        std::cout << "No name entered - nothing to find" << std::endl;
+    }
+}
+
+// Warns that a change could not be saved to the journal
+void UserInterface::checkJournal(bool recorded)
+{
+    if (!recorded)
+        std::cout << "Problem recording the change in the journal -- " << m_journal->getError() << std::endl;
+}
+
 void UserInterface::changeToSubRegion()
 {
     std::string input = getStringInput("Which region would you work with (enter the id):");
@@ -250,21 +402,21 @@ void UserInterface::changeToSubRegion()
         {
             Region* region;
             // DONE: Lookup the region by Id and assign it to the region variable.
-            region=m_currentRegion->getSubRegionByIndex(id);
+            region=m_currentRegion->getSubRegionById(id);
             if (region!=nullptr)
             {
                 UserInterface* nextUI = nullptr;
                 if (region->getType()==Region::CountyType)
                 {
-                    nextUI = new CountyUserInterface(region);
+                    nextUI = new CountyUserInterface(region, m_journal);
                 }
                 else if (region->getType()==Region::StateType)
                 {
-                    nextUI = new StateUserInterface(region);
+                    nextUI = new StateUserInterface(region, m_journal);
                 }
                 else if (region->getType()==Region::NationType)
                 {
-                    nextUI = new NationUserInterface(region);
+                    nextUI = new NationUserInterface(region, m_journal);
                 }
 
                 if (nextUI != nullptr)
@@ -277,6 +429,10 @@ void UserInterface::changeToSubRegion()
                     std::cout << "Can't move into the context of " << region->getName();
                 }
             }
+            else
+            {
+                std::cout << "No region with that id" << std::endl;
+            }
         }
     }
 };
@@ -6,18 +6,25 @@
 #define GEO_REGIONS_USER_INTERFACE_H
 
 #include "Region.h"
+#include <cstdint>
+#include <memory>
 #include <string>
 
 class Menu;
+class RegionJournal;
+class RegionNameIndex;
 
 class UserInterface {
 protected:
     Region*   m_currentRegion = nullptr;
     Menu*     m_menu = nullptr;
+    RegionJournal*  m_journal = nullptr;     // where changes are recorded, if anywhere
     Region::RegionType  m_subRegionType;
+    std::unique_ptr<RegionNameIndex>    m_nameIndex;    // built on the first find, and again after a change
+    std::uint64_t   m_nameIndexChangeCount = 0;         // Region::getChangeCount() when m_nameIndex was built
 
 public:
-    UserInterface(Region* contextRegion);
+    UserInterface(Region* contextRegion, RegionJournal* journal = nullptr);
     ~UserInterface();
     void run();
 
@@ -32,8 +39,13 @@ protected:
     virtual void editPopulation(Region* region);
     virtual void editArea(Region* region);
     virtual void remove();
+    virtual void relocate();
     virtual void print();
+    virtual void writeRollupReport();
+    virtual void find();
+    virtual void showInstrumentation();
     virtual void changeToSubRegion();
+    void checkJournal(bool recorded);
 
 };
 
@@ -6,12 +6,32 @@
 #include <algorithm>
 #include <string>
 #include <iostream>
-#include <sstream>
 #include <fstream>
 #include <cmath>
 #include <limits>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
 #include "Utils.h"
 
+namespace
+{
+    // Shared by both versions of split.  Pieces are taken one delimiter at a time, the same way std::getline would, so
+    // an empty trailing piece is not counted.
+    template <typename Piece>
+    bool splitInto(std::string_view s, char delimiter, Piece pieces[], int expectedNumberOfPieces)
+    {
+        int i=0;
+        while (!s.empty() && i<expectedNumberOfPieces)
+        {
+            std::size_t delimiterPos = s.find(delimiter);
+            pieces[i++] = trimView(s.substr(0, delimiterPos));
+            s.remove_prefix(delimiterPos == std::string_view::npos ? s.size() : delimiterPos + 1);
+        }
+        return (i==expectedNumberOfPieces);
+    }
+}
+
 std::string getStringInput(std::string prompt)
 {
     std::string userInput;
@@ -29,108 +49,138 @@ std::string getStringInput(std::string prompt)
 // Return a true if the string was split into the expected number of pieces, otherwise a it return a false.
 bool split(const std::string& s, char delimiter, std::string pieces[], int expectedNumberOfPieces)
 {
-    std::stringstream ss;
-    ss.str(s);
-    std::string item;
-
-    int i=0;
-    while (std::getline(ss, item, delimiter) && i<expectedNumberOfPieces)
-    {
-        pieces[i++] = trim(item);
-    }
-    return (i==expectedNumberOfPieces);
+    return splitInto(s, delimiter, pieces, expectedNumberOfPieces);
 }
 
 int convertStringToInt(const std::string& s, bool* valid)
 {
-    int result = 0;
-    if (valid!= nullptr)
-        *valid = false;
+    return parseInt(s, valid);
+}
 
-    std::size_t numberOfConvertedCharacters = 0;
-    if (s!="")
+unsigned int convertStringToUnsignedInt(const std::string& s, bool* valid)
+{
+    return parseUnsignedInt(s, valid);
+}
+
+// Converts a string to a double
+//
+// Return the double value represented (0 if the string is not value) and set a valid flag, if provided, if the string
+// represented an acceptable double.  The valid flag is a point to a bool.  If the pointer is null, then the function
+// will still try to convert the string, but it will not try to set the valid flag.
+double convertStringToDouble(const std::string& s, bool* valid)
+{
+    return parseDouble(s, valid);
+}
+
+// Same as split for strings, except the pieces are trimmed views into s rather than new strings.  Pieces past the
+// ones found are left untouched.
+bool split(std::string_view s, char delimiter, std::string_view pieces[], int expectedNumberOfPieces)
+{
+    return splitInto(s, delimiter, pieces, expectedNumberOfPieces);
+}
+
+// Converts a string to an int, accepting the same input as convertStringToInt: surrounding whitespace, an optional
+// sign, and then only decimal digits, within the range of an int.
+//
+// Return the int value represented (0 if the string is not valid) and set the valid flag, if provided.
+int parseInt(std::string_view s, bool* valid)
+{
+    s = trimView(s);
+    bool isNegative = (!s.empty() && s.front()=='-');
+    if (!s.empty() && (s.front()=='-' || s.front()=='+'))
+        s.remove_prefix(1);
+
+    const unsigned long long limit = isNegative ? (unsigned long long) INT_MAX + 1 : INT_MAX;
+    unsigned long long magnitude = 0;
+    bool isValid = !s.empty();
+    for (std::size_t i=0; i<s.length() && isValid; i++)
     {
-        try {
-            std::string trimmedString = trim(s);
-            result = std::stoi(trimmedString, &numberOfConvertedCharacters);
-            if (valid!=nullptr && numberOfConvertedCharacters==trimmedString.length())
-                *valid = true;
-            else if (numberOfConvertedCharacters!=trimmedString.length())
-                result = 0;
-        }
-        catch (std::exception)
-        {
-            // do nothing, let the result remain 0 and the valid flag false
-        }
+        isValid = (s[i]>='0' && s[i]<='9');
+        magnitude = 10 * magnitude + (s[i] - '0');
+        isValid = isValid && magnitude<=limit;
     }
 
+    if (valid!= nullptr)
+        *valid = isValid;
+
+    int result = 0;
+    if (isValid)
+        result = isNegative ? (int) (0 - magnitude) : (int) magnitude;
     return result;
 }
 
-unsigned int convertStringToUnsignedInt(const std::string& s, bool* valid)
+// Converts a string to an unsigned int, accepting the same input as convertStringToUnsignedInt: surrounding
+// whitespace, an optional plus sign, and then only decimal digits, up to UINT32_MAX.
+//
+// Return the unsigned int value represented (0 if the string is not valid) and set the valid flag, if provided.
+unsigned int parseUnsignedInt(std::string_view s, bool* valid)
 {
-    unsigned int result = 0;
-    if (valid!= nullptr)
-        *valid = false;
+    s = trimView(s);
+    if (!s.empty() && s.front()=='+')
+        s.remove_prefix(1);
 
-    std::size_t numberOfConvertedCharacters = 0;
-    if (s!="")
+    unsigned long long value = 0;
+    bool isValid = !s.empty();
+    for (std::size_t i=0; i<s.length() && isValid; i++)
     {
-        try {
-            std::string trimmedString = trim(s);
-            if (trimmedString.substr(0,1)!="-")
-            {
-                unsigned long tmp = std::stoul(trimmedString, &numberOfConvertedCharacters);
-                if (tmp <= UINT32_MAX)
-                {
-                    result = (unsigned int) tmp;
-                    if (valid != nullptr && numberOfConvertedCharacters == trimmedString.length())
-                        *valid = true;
-                    else if (numberOfConvertedCharacters != trimmedString.length())
-                        result = 0;
-                }
-            }
-        }
-        catch (std::exception)
-        {
-            // do nothing, let the result remain 0 and the valid flag false
-        }
+        isValid = (s[i]>='0' && s[i]<='9');
+        value = 10 * value + (s[i] - '0');
+        isValid = isValid && value<=UINT32_MAX;
     }
 
-    return result;
+    if (valid!= nullptr)
+        *valid = isValid;
+
+    return isValid ? (unsigned int) value : 0;
 }
 
-// Converts a string to a double
+// Converts a string to a double, accepting the same input as convertStringToDouble.  Like std::stod it relies on
+// strtod, so the accepted forms and the rounding are identical, but the text is copied to a buffer on the stack rather
+// than into a new string, and errors are reported through the valid flag rather than by exceptions.
 //
-// Return the double value represented (0 if the string is not value) and set a valid flag, if provided, if the string
-// represented an acceptable double.  The valid flag is a point to a bool.  If the pointer is null, then the function
-// will still try to convert the string, but it will not try to set the valid flag.
-double convertStringToDouble(const std::string& s, bool* valid)
+// Return the double value represented (0 if the string is not valid) and set the valid flag, if provided.
+double parseDouble(std::string_view s, bool* valid)
 {
-    double result = 0;
-    if (valid!= nullptr)
-        *valid = false;
+    s = trimView(s);
 
-    std::size_t numberOfConvertedCharacters = 0;
-    if (s!="")
+    char buffer[64];
+    std::string longText;
+    const char* text = buffer;
+    if (s.length() < sizeof(buffer))
     {
-        try {
-            std::string trimmedString = trim(s);
-            result = std::stod(trimmedString, &numberOfConvertedCharacters);
-            if (valid!=nullptr && numberOfConvertedCharacters==trimmedString.length())
-                *valid = true;
-            else if (numberOfConvertedCharacters!=trimmedString.length())
-                result = 0;
-        }
-        catch (std::exception)
-        {
-            // do nothing, let the result remain 0 and the valid flag false
-        }
+        s.copy(buffer, s.length());
+        buffer[s.length()] = '\0';
     }
+    else
+    {
+        longText.assign(s);
+        text = longText.c_str();
+    }
+
+    char* end = nullptr;
+    errno = 0;
+    double result = std::strtod(text, &end);
+    bool isValid = !s.empty() && errno!=ERANGE && end==text+s.length();
+    if (!isValid)
+        result = 0;
+
+    if (valid!= nullptr)
+        *valid = isValid;
 
     return result;
 }
 
+// Cuts the next line off the front of text, without its line ending (either \n or \r\n), and advances text past it
+std::string_view nextLine(std::string_view& text)
+{
+    std::size_t endPos = text.find('\n');
+    std::string_view line = text.substr(0, endPos);
+    text.remove_prefix(endPos == std::string_view::npos ? text.size() : endPos + 1);
+    if (!line.empty() && line.back() == '\r')
+        line.remove_suffix(1);
+    return line;
+}
+
 //  Note: trim, leftTrim, and rightTrim were adapted from
 //      http://stackoverflow.com/questions/25829143/c-trim-whitespace-from-a-string
 
@@ -153,7 +203,26 @@ std::string rightTrim(const std::string &inputStr)
 
 // Removes leading and trailing whitespace, include space, tabs, newlines, and returns
 std::string trim(const std::string& str) {
-    return leftTrim(rightTrim(str));
+    return std::string(trimView(str));
+}
+
+// Narrows the view to exclude leading and trailing whitespace, without copying anything
+std::string_view trimView(std::string_view str)
+{
+    while (!str.empty() && !IsNotWhiteSpace(str.front()))
+        str.remove_prefix(1);
+    while (!str.empty() && !IsNotWhiteSpace(str.back()))
+        str.remove_suffix(1);
+    return str;
+}
+
+// Removes leading and trailing whitespace from the string itself
+void trimInPlace(std::string& str)
+{
+    std::string_view trimmed = trimView(str);
+    std::size_t start = trimmed.data() - str.data();
+    str.erase(start + trimmed.length());
+    str.erase(0, start);
 }
 
 // Function to check if a character is a not a whitespace character, namely
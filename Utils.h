@@ -6,6 +6,7 @@
 #define GEO_REGIONS_UTILS_H
 
 #include <string>
+#include <string_view>
 #include <fstream>
 
 std::string getStringInput(std::string prompt);
@@ -20,5 +21,16 @@ std::string rightTrim(const std::string &str);
 std::string trim(const std::string& str);
 bool IsNotWhiteSpace (char ch);
 
+// Non-allocating, non-throwing counterparts of the functions above.  The views they produce point into the caller's
+// string, so they are only good for as long as that string is.
+bool split(std::string_view s, char delimiter, std::string_view elements[], int expectedNumberOfElements);
+int parseInt(std::string_view s, bool* valid = nullptr);
+unsigned int parseUnsignedInt(std::string_view s, bool* valid = nullptr);
+double parseDouble(std::string_view s, bool* valid = nullptr);
+
+std::string_view trimView(std::string_view str);
+void trimInPlace(std::string& str);
+std::string_view nextLine(std::string_view& text);
+
 
 #endif //GEO_REGIONS_UTILS_H
@@ -3,11 +3,57 @@
 //
 
 #include "World.h"
+#include "RegionEpoch.h"
 #include <iomanip>
 
-const std::string worldData[3] = {"World", "0", "510100000.0"};
+const std::string_view World::defaultData[3] = {"World", "0", "510100000.0"};
 
-World::World() : Region(WorldType, worldData)
+World::World() : Region(WorldType, defaultData)
 {
     validate();
 }
+
+World::World(std::string_view name, unsigned int population, double area) : Region(WorldType, name, population, area)
+{
+    validate();
+}
+
+// Everything allocated from this world's arenas has to be deleted before the arenas are released with m_arenas.
+// Regions removed while readers were looking at them may still be waiting in RegionEpoch to be deleted, so that is
+// finished first, and then the sub-regions still in the world are deleted.
+World::~World()
+{
+    RegionEpoch::synchronize();
+    deleteSubRegions();
+}
+
+// Return the arena that regions loaded into this world are allocated from, creating it the first time
+RegionArena* World::useArena()
+{
+    if (m_arenas.empty())
+        m_arenas.emplace_back(new RegionArena());
+    return m_arenas.front().get();
+}
+
+// Takes ownership of an arena that some of this world's regions were allocated from, e.g., by a loader thread
+void World::adoptArena(std::unique_ptr<RegionArena> arena)
+{
+    if (arena != nullptr)
+        m_arenas.push_back(std::move(arena));
+}
+
+// Moves all of the source's nations into this world, along with the arenas they may have been allocated from, so
+// they live as long as this world does.  Only pointers move, however big the source is.
+//
+// Return false, without moving anything, if the source is this world.
+bool World::mergeWorld(World& source)
+{
+    bool merged = mergeSubregions(source, false);
+    if (merged)
+    {
+        for (std::unique_ptr<RegionArena>& arena : source.m_arenas)
+            m_arenas.push_back(std::move(arena));
+        source.m_arenas.clear();
+    }
+    return merged;
+}
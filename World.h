@@ -6,10 +6,28 @@
 #define GEO_REGIONS_SET_OF_NATIONS_H
 
 #include "Region.h"
+#include "RegionArena.h"
+
+#include <memory>
+#include <vector>
 
 class World : public Region {
+public:
+    static constexpr RegionType regionType = WorldType;
+    static const std::string_view defaultData[3];       // name, population, and area of every world
+
+private:
+    std::vector<std::unique_ptr<RegionArena>> m_arenas;     // the first one is where new regions are allocated
+
 public:
     World();
+    World(std::string_view name, unsigned int population, double area);
+    ~World();
+
+    RegionArena* getArena() const { return m_arenas.empty() ? nullptr : m_arenas.front().get(); }
+    RegionArena* useArena();
+    void adoptArena(std::unique_ptr<RegionArena> arena);
+    bool mergeWorld(World& source);
 };
 
 
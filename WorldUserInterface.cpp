@@ -5,7 +5,7 @@
 #include "WorldUserInterface.h"
 #include "Menu.h"
 
-WorldUserInterface::WorldUserInterface(Region* region) : UserInterface(region)
+WorldUserInterface::WorldUserInterface(Region* region, RegionJournal* journal) : UserInterface(region, journal)
 {
 }
 
@@ -23,7 +23,10 @@ void WorldUserInterface::setupMenu()
     m_menu->addOption("E", "Edit a nation");
     m_menu->addOption("D", "Delete a nation");
     m_menu->addOption("P", "Print a report containing all nations");
+    m_menu->addOption("T", "Write the population, area, and density totals of every region to a file");
     m_menu->addOption("M", "Move into the context of a nation");
+    m_menu->addOption("F", "Find regions anywhere in the world by name");
+    m_menu->addOption("I", "Show the instrumentation counters and timers");
 }
 
 
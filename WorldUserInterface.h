@@ -11,7 +11,7 @@
 class WorldUserInterface : public UserInterface
 {
 public:
-    WorldUserInterface(Region* region);
+    WorldUserInterface(Region* region, RegionJournal* journal = nullptr);
 
 protected:
     Region::RegionType getSubRegionType();
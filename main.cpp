@@ -1,49 +1,163 @@
+#include <cstdio>
 #include <fstream>
 #include <iostream>
 
+#include "BatchCommandRunner.h"
+#include "RegionJournal.h"
+#include "StreamingReporter.h"
 #include "World.h"
 #include "WorldUserInterface.h"
 
-int main()
+const std::string dataFile = "Nations.txt";
+const std::string snapshotFile = "Nations.snapshot";
+const std::string journalFile = "Nations.journal";
+
+// The first region in a file should be a world, and all of it's sub-regions.  Return nullptr for anything else.
+Region* loadWorld(Region* region)
+{
+    if (region!=nullptr && region->getType()!=Region::WorldType)
+    {
+        RegionDeleter()(region);
+        region = nullptr;
+    }
+    return region;
+}
+
+// Renames a file that couldn't be loaded, so it is kept for whoever repairs it.  Return false if it is still there.
+bool moveAside(const std::string& filename)
 {
-    std::cout << "Welcome to the GeoRegions system" << std::endl << std::endl;
+    std::string damagedFile = filename + ".damaged";
+    std::remove(damagedFile.c_str());
+    if (std::rename(filename.c_str(), damagedFile.c_str())==0)
+    {
+        std::cout << "Kept " << filename << " as " << damagedFile << std::endl;
+        return true;
+    }
+    if (!std::ifstream(filename).is_open())
+        return true;
 
-    // Create a world object
-    World* world;
+    std::cerr << "Problem moving " << filename << " to " << damagedFile << " -- not starting, so it isn't lost"
+              << std::endl;
+    return false;
+}
 
-    // Load if from the data file, if possible
-    std::ifstream inputStream("Nations.txt");
-    if (inputStream.is_open())
+int main(int argc, char* argv[])
+{
+    // GeoRegions --list <data file> or --display <data file> writes a report to standard output straight from the
+    // data file, without loading it, so it works for files that are bigger than memory
+    if (argc==3 && (std::string(argv[1])=="--list" || std::string(argv[1])=="--display"))
     {
-        // Try to load the first region in the field, which should be a world, and all of it's sub-regions
-        Region* region = Region::create(inputStream);
-        if (region!= nullptr && region->getType()==Region::WorldType)
+        StreamingReporter::ReportType reportType = (std::string(argv[1])=="--list") ?
+                StreamingReporter::ListReport : StreamingReporter::DisplayReport;
+        std::ifstream inputStream(argv[2]);
+        if (!inputStream.is_open() || !StreamingReporter::write(inputStream, std::cout, reportType))
         {
-            world = (World*) region;
-            std::cout << "Loaded a world and "  << world->getSubRegionCount() << " nations from Nations.txt" << std::endl;
+            std::cerr << "Problem reporting on " << argv[2] << std::endl;
+            return 1;
         }
-        else
+        return 0;
+    }
+
+    // GeoRegions --batch <command file> runs the commands in the file against the world instead of the menus, and
+    // saves the changes the same way
+    std::ifstream batchStream;
+    bool isBatch = (argc==3 && std::string(argv[1])=="--batch");
+    if (isBatch)
+    {
+        batchStream.open(argv[2]);
+        if (!batchStream.is_open())
         {
-            world = new World();
-            std::cout << "Problem loading Nation.txt -- created a new world" << std::endl;
+            std::cerr << "Problem opening " << argv[2] << std::endl;
+            return 1;
         }
-        inputStream.close();
     }
     else
     {
-        world = new World();
+        std::cout << "Welcome to the GeoRegions system" << std::endl << std::endl;
+    }
+
+    // Load the world from the binary snapshot if there is one, since that is much faster, otherwise from the data file.
+    // A file that is there but can't be loaded is moved aside rather than written over when the world is saved.
+    std::string sourceFile = snapshotFile;
+    bool fileFound = false;
+    std::uint32_t generation = 0;
+    RegionPtr region(loadWorld(Region::loadSnapshot(snapshotFile, &fileFound, true, &generation)));
+    bool isFromSnapshot = (region!=nullptr);
+    if (fileFound && !isFromSnapshot)
+    {
+        // The journal only goes with the snapshot, so it is kept with it
+        std::cout << "Problem loading " << snapshotFile << " -- loading " << dataFile << " instead" << std::endl;
+        if (!moveAside(snapshotFile) || !moveAside(journalFile))
+            return 1;
+    }
+    if (!isFromSnapshot)
+    {
+        sourceFile = dataFile;
+        region.reset(loadWorld(Region::load(dataFile, &fileFound, true, 0)));
+        if (fileFound && region==nullptr && !moveAside(dataFile))
+            return 1;
+    }
+
+    // The handle owns the world, which is always a World, since that is what Region::create makes for a WorldType
+    if (region!=nullptr)
+    {
+        std::cout << "Loaded a world and "  << region->getSubRegionCount() << " nations from " << sourceFile << std::endl;
+    }
+    else if (fileFound)
+    {
+        region.reset(new World());
+        std::cout << "Problem loading " << sourceFile << " -- created a new world" << std::endl;
+    }
+    else
+    {
+        region.reset(new World());
         std::cout << "Created a new world" << std::endl;
     }
+    World* world = static_cast<World*>(region.get());
+
+    // Every change is recorded in the journal as it is made, so it survives even if the program doesn't exit
+    // normally.  The journal only goes with the snapshot it was started from, so a world that came from anywhere else
+    // gets a snapshot of its own first.
+    RegionJournal journal(journalFile, snapshotFile);
+    std::size_t replayed = journal.open(*world, generation, isFromSnapshot);
+    if (replayed>0)
+    {
+        std::cout << "Replayed " << replayed << " changes from " << journalFile << std::endl;
+    }
+    if (!isFromSnapshot)
+    {
+        journal.compact();
+    }
+    if (!journal.isOpen())
+    {
+        std::cout << "Problem opening " << journalFile << " -- " << journal.getError() << std::endl;
+    }
+
+    // Run the batch commands or the main user interface
+    std::size_t failureCount = 0;
+    if (isBatch)
+    {
+        BatchCommandRunner runner(*world, std::cout, &journal);
+        failureCount = runner.run(batchStream);
+        std::cout << "Ran " << runner.getCommandCount() << " commands, " << failureCount << " failed" << std::endl;
+    }
+    else
+    {
+        WorldUserInterface mainUI(world, &journal);
+        mainUI.run();
+    }
 
-    // Run the main user interface
-    WorldUserInterface mainUI(world);
-    mainUI.run();
+    // Save the world!  The snapshot is what gets loaded next time, and the text file is kept as a readable export.
+    if (!journal.compact())
+    {
+        std::cout << "Problem saving " << snapshotFile << " -- " << journal.getError() << std::endl;
+    }
 
-    // Save the world!
-    std::ofstream outputStream("Nations.txt");
-    if (outputStream.is_open())
+    std::string error;
+    if (!world->save(dataFile, true, &error))
     {
-        world->save(outputStream);
+        std::cout << "Problem saving " << dataFile << " -- " << error << std::endl;
     }
-    outputStream.close();
-}
\ No newline at end of file
+
+    return (failureCount>0) ? 1 : 0;
+}